@@ -0,0 +1,159 @@
+#include "Shiny/Math/Transform.h"
+#include "Shiny/Math/TransformBatch.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace Shiny;
+
+namespace {
+
+const std::size_t kNumTransforms = 4096;
+const int kNumIterations = 2000;
+
+// Keeps the optimizer from discarding results that are never read
+volatile float sink = 0.0f;
+
+std::vector<Transform> makeTransforms(std::mt19937& generator) {
+   std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+   std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+   std::uniform_real_distribution<float> scale(0.25f, 4.0f);
+
+   std::vector<Transform> transforms(kNumTransforms);
+   for (Transform& transform : transforms) {
+      glm::quat orientation(unit(generator), unit(generator), unit(generator), unit(generator));
+      transform.orientation = glm::normalize(orientation);
+      transform.position = glm::vec3(position(generator), position(generator), position(generator));
+      transform.scale = glm::vec3(scale(generator), scale(generator), scale(generator));
+   }
+
+   return transforms;
+}
+
+template<typename Function>
+double nanosecondsPerTransform(Function&& function) {
+   auto begin = std::chrono::steady_clock::now();
+   for (int i = 0; i < kNumIterations; ++i) {
+      function();
+   }
+   auto end = std::chrono::steady_clock::now();
+
+   double nanoseconds = std::chrono::duration<double, std::nano>(end - begin).count();
+   return nanoseconds / (static_cast<double>(kNumIterations) * kNumTransforms);
+}
+
+float maxDifference(const Transform& first, const Transform& second) {
+   float difference = 0.0f;
+   for (int i = 0; i < 4; ++i) {
+      difference = std::max(difference, std::abs(first.orientation[i] - second.orientation[i]));
+   }
+   for (int i = 0; i < 3; ++i) {
+      difference = std::max(difference, std::abs(first.position[i] - second.position[i]));
+      difference = std::max(difference, std::abs(first.scale[i] - second.scale[i]));
+   }
+
+   return difference;
+}
+
+float maxDifference(const glm::mat4& first, const glm::mat4& second) {
+   float difference = 0.0f;
+   for (int column = 0; column < 4; ++column) {
+      for (int row = 0; row < 4; ++row) {
+         difference = std::max(difference, std::abs(first[column][row] - second[column][row]));
+      }
+   }
+
+   return difference;
+}
+
+template<typename T>
+float maxDifference(const std::vector<T>& first, const std::vector<T>& second) {
+   float difference = 0.0f;
+   for (std::size_t i = 0; i < first.size(); ++i) {
+      difference = std::max(difference, maxDifference(first[i], second[i]));
+   }
+
+   return difference;
+}
+
+void report(const char* name, double scalarNanoseconds, double batchNanoseconds, float difference) {
+   std::printf("%-16s scalar %7.2f ns   batch %7.2f ns   speedup %5.2fx   max difference %g\n", name, scalarNanoseconds,
+               batchNanoseconds, scalarNanoseconds / batchNanoseconds, difference);
+}
+
+} // namespace
+
+/**
+ * Times the TransformBatch kernels against the single transform versions they replace, and reports the largest
+ * difference between their results
+ */
+int main() {
+   std::mt19937 generator(12345);
+   std::vector<Transform> first = makeTransforms(generator);
+   std::vector<Transform> second = makeTransforms(generator);
+
+   std::vector<Transform> scalarTransforms(kNumTransforms);
+   std::vector<Transform> batchTransforms(kNumTransforms);
+   std::vector<glm::mat4> scalarMatrices(kNumTransforms);
+   std::vector<glm::mat4> batchMatrices(kNumTransforms);
+
+   std::printf("%lu transforms, %d iterations (times are per transform)\n", static_cast<unsigned long>(kNumTransforms),
+               kNumIterations);
+
+   double scalar = nanosecondsPerTransform([&]() {
+      for (std::size_t i = 0; i < kNumTransforms; ++i) {
+         scalarTransforms[i] = first[i] * second[i];
+      }
+      sink = sink + scalarTransforms[0].position.x;
+   });
+   double batch = nanosecondsPerTransform([&]() {
+      TransformBatch::multiply(batchTransforms.data(), first.data(), second.data(), kNumTransforms);
+      sink = sink + batchTransforms[0].position.x;
+   });
+   report("multiply", scalar, batch, maxDifference(scalarTransforms, batchTransforms));
+
+   scalar = nanosecondsPerTransform([&]() {
+      for (std::size_t i = 0; i < kNumTransforms; ++i) {
+         scalarTransforms[i] = first[i].inverse();
+      }
+      sink = sink + scalarTransforms[0].position.x;
+   });
+   batch = nanosecondsPerTransform([&]() {
+      TransformBatch::inverse(batchTransforms.data(), first.data(), kNumTransforms);
+      sink = sink + batchTransforms[0].position.x;
+   });
+   report("inverse", scalar, batch, maxDifference(scalarTransforms, batchTransforms));
+
+   scalar = nanosecondsPerTransform([&]() {
+      for (std::size_t i = 0; i < kNumTransforms; ++i) {
+         scalarMatrices[i] = first[i].toMatrix();
+      }
+      sink = sink + scalarMatrices[0][3][0];
+   });
+   batch = nanosecondsPerTransform([&]() {
+      TransformBatch::toMatrix(batchMatrices.data(), first.data(), kNumTransforms);
+      sink = sink + batchMatrices[0][3][0];
+   });
+   report("toMatrix", scalar, batch, maxDifference(scalarMatrices, batchMatrices));
+
+   scalar = nanosecondsPerTransform([&]() {
+      for (std::size_t i = 0; i < kNumTransforms; ++i) {
+         scalarMatrices[i] = first[i].toNormalMatrix();
+      }
+      sink = sink + scalarMatrices[0][0][0];
+   });
+   batch = nanosecondsPerTransform([&]() {
+      TransformBatch::toNormalMatrix(batchMatrices.data(), first.data(), kNumTransforms);
+      sink = sink + batchMatrices[0][0][0];
+   });
+   report("toNormalMatrix", scalar, batch, maxDifference(scalarMatrices, batchMatrices));
+
+   return 0;
+}
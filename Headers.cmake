@@ -17,10 +17,20 @@ set(HEADER_NAMES
    Audio/Sound.h
    Audio/Stream.h
    Entity/Component.h
+   Entity/ComponentPool.h
+   Entity/ComponentStorage.h
+   Entity/ComponentType.h
    Entity/Delegate.h
    Entity/Entity.h
+   Entity/EntityHandle.h
+   Entity/Prefab.h
+   Entity/System.h
+   Entity/SystemScheduler.h
    Graphics/Context.h
    Graphics/Framebuffer.h
+   Graphics/FrameStats.h
+   Graphics/FrameUniforms.h
+   Graphics/GpuProfiler.h
    Graphics/Material.h
    Graphics/Mesh.h
    Graphics/Model.h
@@ -40,19 +50,31 @@ set(HEADER_NAMES
    Input/Keyboard.h
    Input/Keys.h
    Input/Mouse.h
+   Math/Bounds.h
+   Math/DynamicBvh.h
+   Math/Frustum.h
    Math/MathUtils.h
    Math/Transform.h
+   Math/TransformBatch.h
    Platform/IOUtils.h
    Platform/OSUtils.h
    Platform/Path.h
+   Platform/ThreadPool.h
    Scene/CameraComponent.h
    Scene/DirectionalLightComponent.h
+   Scene/LightClusters.h
    Scene/LightComponent.h
    Scene/ModelComponent.h
    Scene/PointLightComponent.h
+   Scene/RenderCommandList.h
+   Scene/RenderQueue.h
    Scene/Scene.h
+   Scene/SceneCommandBuffer.h
+   Scene/SceneRenderer.h
+   Scene/SceneView.h
    Scene/SpotLightComponent.h
    Scene/TransformComponent.h
+   Scene/TransformHierarchy.h
    Text/Font.h
    Text/FontAtlas.h
    Text/TextRenderer.h
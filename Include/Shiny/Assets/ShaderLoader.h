@@ -48,6 +48,19 @@ class ShaderProgram;
 
 class ShaderLoader {
 public:
+   /**
+    * Replaced with "0" in all shader sources unless given in the definitions. Shaders that support instanced rendering
+    * read their matrices from the per-instance aInstanceModelMatrix / aInstanceNormalMatrix attributes under
+    * "#if SHINY_INSTANCED", and are loaded with { ShaderLoader::kInstancingDefinition, "1" }.
+    */
+   static const char* const kInstancingDefinition;
+
+   /**
+    * Replaced with "0" unless given, like kInstancingDefinition. Lets a single shader source provide both a model's main
+    * program and its G-buffer program (see SceneRenderer), loaded with { ShaderLoader::kGBufferDefinition, "1" }.
+    */
+   static const char* const kGBufferDefinition;
+
    /**
    * Loads the shader with the given path and type, using a cached version if possible
    */
@@ -6,10 +6,15 @@
 
 #include "Shiny/Audio/AudioSystem.h"
 
+#include "Shiny/Entity/SystemScheduler.h"
+
 #include "Shiny/Graphics/Context.h"
+#include "Shiny/Graphics/GpuProfiler.h"
 
 #include "Shiny/Input/Controller.h"
 
+#include "Shiny/Platform/ThreadPool.h"
+
 #include <array>
 #include <functional>
 
@@ -20,6 +25,7 @@ namespace Shiny {
 
 class Keyboard;
 class Mouse;
+class Scene;
 
 typedef UPtr<GLFWwindow, std::function<void(GLFWwindow*)>> WindowPtr;
 
@@ -52,6 +58,9 @@ protected:
    WindowPtr window;
    AudioSystem audioSystem;
    Context context;
+   ThreadPool threadPool;
+   SystemScheduler systemScheduler;
+   Scene* scene;
    SPtr<Keyboard> keyboard;
    SPtr<Mouse> mouse;
    std::array<SPtr<Controller>, kMaxControllers> controllers;
@@ -96,6 +105,23 @@ public:
    bool isRunning() const;
 
    float getRunningTime() const;
+
+   Scene* getScene() const {
+      return scene;
+   }
+
+   /**
+    * Sets the scene that the system scheduler runs on. Its systems run once per tick, right after tick() (so before the
+    * frame is rendered), and its command buffer is flushed after them. May be null, in which case no systems are run.
+    */
+   void setScene(Scene* newScene) {
+      scene = newScene;
+   }
+
+   /**
+    * GPU timings of a recent frame, from the SHINY_GPU_SCOPEs (empty unless SHINY_GPU_PROFILING is enabled)
+    */
+   const GpuProfile& getGpuProfile() const;
 };
 
 } // namespace Shiny
@@ -3,10 +3,15 @@
 
 #include "Shiny/Pointers.h"
 #include "Shiny/ShinyAssert.h"
+#include "Shiny/Entity/ComponentPool.h"
+#include "Shiny/Entity/ComponentStorage.h"
+#include "Shiny/Entity/ComponentType.h"
 #include "Shiny/Entity/Delegate.h"
 
+#include <new>
 #include <string>
 #include <unordered_map>
+#include <utility>
 
 namespace Shiny {
 
@@ -26,8 +31,9 @@ public:
 
    void destroy();
 
-   OnDestroyDelegate::Handle bindOnDestroy(const OnDestroyDelegate::FuncType& function) {
-      return onDestroy.bind(function);
+   template<typename Function>
+   OnDestroyDelegate::Handle bindOnDestroy(Function&& function) {
+      return onDestroy.bind(std::forward<Function>(function));
    }
 
    Entity& getOwner() {
@@ -61,14 +67,10 @@ public:
    ~ComponentRegistrar();
 
 private:
-   friend class ComponentRegistry;
+   friend class ComponentStorage<T>;
 
-   static UPtr<T> createTypedComponent(Entity& entity) {
-      return UPtr<T>(new T(entity));
-   }
-
-   static UPtr<Component> createComponent(Entity& entity) {
-      return createTypedComponent(entity);
+   static T* constructComponent(void* memory, Entity& entity) {
+      return new (memory) T(entity);
    }
 
    std::string componentClassName;
@@ -101,16 +103,53 @@ public:
    ComponentRegistry& operator=(const ComponentRegistry& other) = delete;
    ComponentRegistry& operator=(ComponentRegistry&& other) = delete;
 
+   /**
+    * Returns the allocation stats of the registered component class with the given name, or null if there is none
+    */
+   const ComponentPoolStats* getPoolStats(const std::string& className) const {
+      auto itr = componentMap.find(className);
+      if (itr != componentMap.end()) {
+         return &itr->second.pool->getStats();
+      }
+
+      return nullptr;
+   }
+
+   /**
+    * Looks up the type ID and storage creation function of the registered component class with the given name
+    */
+   bool getComponentType(const std::string& className, ComponentTypeId& typeId, ComponentStore::CreateStorageFunc& createStorageFunc) const {
+      auto itr = componentMap.find(className);
+      if (itr != componentMap.end()) {
+         typeId = itr->second.typeId;
+         createStorageFunc = itr->second.createStorageFunc;
+         return true;
+      }
+
+      return false;
+   }
+
+   template<typename Function>
+   void forEachPoolStats(Function&& function) const {
+      for (const auto& pair : componentMap) {
+         function(pair.first, pair.second.pool->getStats());
+      }
+   }
+
 private:
    template<typename T> friend class ComponentRegistrar;
    friend class Entity;
 
-   using CreateComponentFunc = UPtr<Component>(*)(Entity&);
+   struct ComponentType {
+      ComponentTypeId typeId;
+      ComponentStore::CreateStorageFunc createStorageFunc;
+      ComponentPoolBase* pool;
+   };
 
    ComponentRegistry() = default;
 
-   void registerComponent(const std::string& className, CreateComponentFunc createComponentFunc) {
-      auto pair = componentMap.insert({ className, createComponentFunc });
+   void registerComponent(const std::string& className, const ComponentType& componentType) {
+      auto pair = componentMap.insert({ className, componentType });
       ASSERT(pair.second, "Trying to register a component that has already been registered!");
    }
 
@@ -121,27 +160,25 @@ private:
       componentMap.erase(itr);
    }
 
-   template<typename T>
-   UPtr<T> createComponent(Entity& entity) {
-      return ComponentRegistrar<T>::createTypedComponent(entity);
-   }
-
-   UPtr<Component> createComponent(Entity& entity, const std::string& className) {
+   ComponentStorageBase* getStorage(ComponentStore& store, const std::string& className) {
       auto itr = componentMap.find(className);
       if (itr != componentMap.end()) {
-         return itr->second(entity);
+         return &store.getStorage(itr->second.typeId, itr->second.createStorageFunc);
       }
 
       return nullptr;
    }
 
-   std::unordered_map<std::string, CreateComponentFunc> componentMap;
+   std::unordered_map<std::string, ComponentType> componentMap;
 };
 
 template<typename T>
 ComponentRegistrar<T>::ComponentRegistrar(const std::string& className)
    : componentClassName(className) {
-   ComponentRegistry::instance().registerComponent(componentClassName, &createComponent);
+   // Assign the type ID (and those of all superclasses) up front, so that IDs are stable regardless of lookup order
+   ComponentTypeInfo<T>::ancestorMask();
+
+   ComponentRegistry::instance().registerComponent(componentClassName, { ComponentTypeInfo<T>::id(), &ComponentStorage<T>::createStorage, &ComponentPool<T>::instance() });
 }
 
 template<typename T>
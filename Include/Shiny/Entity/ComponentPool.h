@@ -0,0 +1,165 @@
+#ifndef SHINY_COMPONENT_POOL_H
+#define SHINY_COMPONENT_POOL_H
+
+#include "Shiny/Pointers.h"
+#include "Shiny/ShinyAssert.h"
+
+#include <cstddef>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Shiny {
+
+struct ComponentPoolStats {
+   std::size_t liveCount = 0;
+   std::size_t peakCount = 0;
+   std::size_t bytesReserved = 0;
+};
+
+class ComponentPoolBase {
+public:
+   ComponentPoolBase()
+      : owningThread(std::this_thread::get_id()) {
+   }
+   ComponentPoolBase(const ComponentPoolBase& other) = delete;
+   ComponentPoolBase(ComponentPoolBase&& other) = delete;
+
+   virtual ~ComponentPoolBase() = default;
+
+   ComponentPoolBase& operator=(const ComponentPoolBase& other) = delete;
+   ComponentPoolBase& operator=(ComponentPoolBase&& other) = delete;
+
+   const ComponentPoolStats& getStats() const {
+      return stats;
+   }
+
+protected:
+   void assertOwningThread() const {
+      ASSERT(std::this_thread::get_id() == owningThread,
+             "Component pools are not thread safe, components must be created and destroyed on the main thread");
+   }
+
+   ComponentPoolStats stats;
+
+private:
+   // Pools are created when their component type is registered (during static initialization, so on the main thread)
+   const std::thread::id owningThread;
+};
+
+/**
+ * Slab allocator for all components of exactly type T (shared by every scene). Memory is reserved in fixed-size chunks
+ * and recycled through an intrusive free list, so once the pool has grown to the peak count, creating components no
+ * longer touches the global allocator. Not thread safe - components must be created and destroyed on the main thread (the
+ * thread that created the pool), which is asserted. Systems running on other threads go through the scene's command
+ * buffer instead.
+ */
+template<typename T>
+class ComponentPool : public ComponentPoolBase {
+public:
+   static const std::size_t kChunkSize = 128;
+
+   struct Deleter {
+      void operator()(T* component) const {
+         if (component) {
+            component->~T();
+            ComponentPool<T>::instance().deallocate(component);
+         }
+      }
+   };
+
+   using Ptr = UPtr<T, Deleter>;
+
+   static ComponentPool& instance() {
+      // Intentionally leaked, so that components destroyed during static destruction can still be returned to the pool
+      static ComponentPool* pool = new ComponentPool;
+      return *pool;
+   }
+
+   /**
+    * Returns uninitialized memory for a single T
+    */
+   void* allocate() {
+      assertOwningThread();
+
+      if (!freeList) {
+         addChunk();
+      }
+
+      FreeNode* node = freeList;
+      freeList = node->next;
+
+      ++stats.liveCount;
+      if (stats.liveCount > stats.peakCount) {
+         stats.peakCount = stats.liveCount;
+      }
+
+      return node;
+   }
+
+   /**
+    * Returns memory obtained from allocate() to the pool (the object must already have been destroyed)
+    */
+   void deallocate(void* memory) {
+      ASSERT(memory && stats.liveCount > 0, "Trying to deallocate memory that was not allocated by the pool");
+      assertOwningThread();
+
+      FreeNode* node = static_cast<FreeNode*>(memory);
+      node->next = freeList;
+      freeList = node;
+
+      --stats.liveCount;
+   }
+
+   /**
+    * Makes sure that at least the given number of components can be live without reserving more memory
+    */
+   void reserve(std::size_t count) {
+      assertOwningThread();
+
+      while (chunks.size() * kChunkSize < count) {
+         addChunk();
+      }
+   }
+
+private:
+   // Free slots store the free list link in place of the component
+   struct FreeNode {
+      FreeNode* next;
+   };
+
+   static_assert(sizeof(T) >= sizeof(FreeNode) && alignof(T) >= alignof(FreeNode), "Component too small to pool");
+
+   using SlotData = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+   struct Chunk {
+      SlotData slots[kChunkSize];
+   };
+
+   ComponentPool()
+      : freeList(nullptr) {
+   }
+
+   void addChunk() {
+      chunks.push_back(UPtr<Chunk>(new Chunk));
+      stats.bytesReserved += sizeof(Chunk);
+
+      // Link in reverse so that slots are handed out in address order
+      Chunk& chunk = *chunks.back();
+      for (std::size_t i = kChunkSize; i > 0; --i) {
+         FreeNode* node = reinterpret_cast<FreeNode*>(&chunk.slots[i - 1]);
+         node->next = freeList;
+         freeList = node;
+      }
+   }
+
+   std::vector<UPtr<Chunk>> chunks;
+   FreeNode* freeList;
+};
+
+template<typename T>
+const std::size_t ComponentPool<T>::kChunkSize;
+
+} // namespace Shiny
+
+#endif
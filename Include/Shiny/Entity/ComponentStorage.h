@@ -0,0 +1,215 @@
+#ifndef SHINY_COMPONENT_STORAGE_H
+#define SHINY_COMPONENT_STORAGE_H
+
+#include "Shiny/Pointers.h"
+#include "Shiny/ShinyAssert.h"
+#include "Shiny/Entity/ComponentPool.h"
+#include "Shiny/Entity/ComponentType.h"
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace Shiny {
+
+class Component;
+class Entity;
+
+template<typename T>
+class ComponentRegistrar;
+
+class ComponentStorageBase {
+public:
+   using Slot = std::uint32_t;
+
+   ComponentStorageBase(ComponentTypeId inTypeId, ComponentTypeMask inTypeMask)
+      : typeId(inTypeId), typeMask(inTypeMask) {
+   }
+
+   ComponentStorageBase(const ComponentStorageBase& other) = delete;
+   ComponentStorageBase(ComponentStorageBase&& other) = delete;
+
+   virtual ~ComponentStorageBase() = default;
+
+   ComponentStorageBase& operator=(const ComponentStorageBase& other) = delete;
+   ComponentStorageBase& operator=(ComponentStorageBase&& other) = delete;
+
+   virtual Slot create(Entity& entity) = 0;
+   virtual void destroy(Slot slot) = 0;
+   virtual Component* getComponent(Slot slot) = 0;
+
+   /**
+    * Makes room for the given number of additional components
+    */
+   virtual void reserve(std::size_t additionalCount) = 0;
+
+   virtual std::size_t size() const = 0;
+
+   ComponentTypeId getTypeId() const {
+      return typeId;
+   }
+
+   /**
+    * Ancestor mask of the stored component type
+    */
+   ComponentTypeMask getTypeMask() const {
+      return typeMask;
+   }
+
+private:
+   const ComponentTypeId typeId;
+   const ComponentTypeMask typeMask;
+};
+
+/**
+ * Stores all components of exactly type T for a single scene. Component memory comes from the type's ComponentPool, so
+ * components of the same type are packed together in memory but never relocate (pointers to them are handed out to
+ * gameplay code). Live components are also tracked in a dense array (swap-removed on destruction) so that iteration
+ * never visits dead slots.
+ */
+template<typename T>
+class ComponentStorage : public ComponentStorageBase {
+public:
+   static UPtr<ComponentStorageBase> createStorage() {
+      return UPtr<ComponentStorageBase>(new ComponentStorage<T>);
+   }
+
+   ComponentStorage()
+      : ComponentStorageBase(ComponentTypeInfo<T>::id(), ComponentTypeInfo<T>::ancestorMask()) {
+   }
+
+   ~ComponentStorage() {
+      ASSERT(components.empty(), "Destroying component storage that still contains live components");
+   }
+
+   virtual Slot create(Entity& entity) override {
+      Slot slot = 0;
+      if (!freeSlots.empty()) {
+         slot = freeSlots.back();
+         freeSlots.pop_back();
+      } else {
+         ASSERT(slotToDense.size() < std::numeric_limits<Slot>::max(), "Too many components of a single type");
+
+         slot = static_cast<Slot>(slotToDense.size());
+         slotToDense.push_back(kInvalidIndex);
+         slotComponents.emplace_back();
+      }
+
+      T* component = ComponentRegistrar<T>::constructComponent(ComponentPool<T>::instance().allocate(), entity);
+      slotComponents[slot].reset(component);
+
+      slotToDense[slot] = static_cast<Slot>(components.size());
+      components.push_back(component);
+      componentSlots.push_back(slot);
+
+      return slot;
+   }
+
+   virtual void destroy(Slot slot) override {
+      ASSERT(slot < slotToDense.size() && slotToDense[slot] != kInvalidIndex, "Trying to destroy invalid component slot");
+
+      Slot denseIndex = slotToDense[slot];
+      T* component = components[denseIndex];
+
+      // Swap-remove from the dense arrays
+      Slot lastSlot = componentSlots.back();
+      components[denseIndex] = components.back();
+      componentSlots[denseIndex] = lastSlot;
+      slotToDense[lastSlot] = denseIndex;
+
+      components.pop_back();
+      componentSlots.pop_back();
+      slotToDense[slot] = kInvalidIndex;
+
+      ASSERT(slotComponents[slot].get() == component);
+      slotComponents[slot].reset();
+      freeSlots.push_back(slot);
+   }
+
+   virtual Component* getComponent(Slot slot) override {
+      return get(slot);
+   }
+
+   virtual void reserve(std::size_t additionalCount) override {
+      std::size_t count = components.size() + additionalCount;
+      components.reserve(count);
+      componentSlots.reserve(count);
+
+      if (count > slotToDense.size()) {
+         slotToDense.reserve(count);
+         slotComponents.reserve(count);
+      }
+
+      ComponentPool<T>& pool = ComponentPool<T>::instance();
+      pool.reserve(pool.getStats().liveCount + additionalCount);
+   }
+
+   virtual std::size_t size() const override {
+      return components.size();
+   }
+
+   T* get(Slot slot) {
+      ASSERT(slot < slotToDense.size() && slotToDense[slot] != kInvalidIndex, "Trying to access invalid component slot");
+      return slotComponents[slot].get();
+   }
+
+   const std::vector<T*>& getComponents() const {
+      return components;
+   }
+
+private:
+   static const Slot kInvalidIndex = std::numeric_limits<Slot>::max();
+
+   std::vector<typename ComponentPool<T>::Ptr> slotComponents;
+   std::vector<Slot> freeSlots;
+   std::vector<Slot> slotToDense;
+
+   std::vector<T*> components;
+   std::vector<Slot> componentSlots;
+};
+
+template<typename T>
+const ComponentStorageBase::Slot ComponentStorage<T>::kInvalidIndex;
+
+/**
+ * Owns the component storage of every component type used in a scene
+ */
+class ComponentStore {
+public:
+   using CreateStorageFunc = UPtr<ComponentStorageBase>(*)();
+
+   ComponentStore() = default;
+   ComponentStore(const ComponentStore& other) = delete;
+   ComponentStore(ComponentStore&& other) = delete;
+   ComponentStore& operator=(const ComponentStore& other) = delete;
+   ComponentStore& operator=(ComponentStore&& other) = delete;
+
+   template<typename T>
+   ComponentStorage<T>& getStorage() {
+      return static_cast<ComponentStorage<T>&>(getStorage(ComponentTypeInfo<T>::id(), &ComponentStorage<T>::createStorage));
+   }
+
+   ComponentStorageBase& getStorage(ComponentTypeId typeId, CreateStorageFunc createStorageFunc) {
+      ASSERT(typeId < kMaxComponentTypes, "Invalid component type ID: %u", typeId);
+
+      UPtr<ComponentStorageBase>& storage = storages[typeId];
+      if (!storage) {
+         storage = createStorageFunc();
+      }
+
+      return *storage;
+   }
+
+   template<typename T>
+   const ComponentStorage<T>* findStorage() const {
+      return static_cast<const ComponentStorage<T>*>(storages[ComponentTypeInfo<T>::id()].get());
+   }
+
+private:
+   std::array<UPtr<ComponentStorageBase>, kMaxComponentTypes> storages;
+};
+
+} // namespace Shiny
+
+#endif
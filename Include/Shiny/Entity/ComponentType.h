@@ -0,0 +1,80 @@
+#ifndef SHINY_COMPONENT_TYPE_H
+#define SHINY_COMPONENT_TYPE_H
+
+#include <cstdint>
+#include <type_traits>
+
+namespace Shiny {
+
+class Component;
+
+using ComponentTypeId = std::uint32_t;
+using ComponentTypeMask = std::uint64_t;
+
+const ComponentTypeId kMaxComponentTypes = 64;
+
+/**
+ * Declares the component class and its direct superclass, which is used to build the ancestor masks that answer
+ * inheritance queries without RTTI. Must appear in the public section of every component class.
+ */
+#define SHINY_DECLARE_COMPONENT(component_name, super_name) \
+using ComponentClass = component_name; \
+using Super = super_name;
+
+namespace ComponentTypes {
+
+/**
+ * Allocates the next unused component type ID. Registering more than kMaxComponentTypes types logs an error and aborts.
+ */
+ComponentTypeId allocateId();
+
+} // namespace ComponentTypes
+
+/**
+ * Provides the type ID and ancestor mask of a component type. IDs are assigned once per type (when the type's
+ * ComponentRegistrar is constructed, or on first use for unregistered types), so lookups reduce to integer compares.
+ */
+template<typename T>
+class ComponentTypeInfo {
+public:
+   static ComponentTypeId id() {
+      static const ComponentTypeId typeId = ComponentTypes::allocateId();
+      return typeId;
+   }
+
+   static ComponentTypeMask mask() {
+      return ComponentTypeMask(1) << id();
+   }
+
+   /**
+    * Mask containing the bits of the type itself and all of its component superclasses
+    */
+   static ComponentTypeMask ancestorMask() {
+      static_assert(std::is_same<typename T::ComponentClass, T>::value, "Component class is missing SHINY_DECLARE_COMPONENT");
+      static_assert(std::is_base_of<typename T::Super, T>::value, "Component super must be a base class");
+
+      static const ComponentTypeMask ancestors = mask() | ComponentTypeInfo<typename T::Super>::ancestorMask();
+      return ancestors;
+   }
+};
+
+template<>
+class ComponentTypeInfo<Component> {
+public:
+   static ComponentTypeId id() {
+      static const ComponentTypeId typeId = ComponentTypes::allocateId();
+      return typeId;
+   }
+
+   static ComponentTypeMask mask() {
+      return ComponentTypeMask(1) << id();
+   }
+
+   static ComponentTypeMask ancestorMask() {
+      return mask();
+   }
+};
+
+} // namespace Shiny
+
+#endif
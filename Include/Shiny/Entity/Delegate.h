@@ -1,77 +1,340 @@
 #ifndef SHINY_DELEGATE_H
 #define SHINY_DELEGATE_H
 
-#include "Shiny/Pointers.h"
 #include "Shiny/ShinyAssert.h"
 
-#include <algorithm>
-#include <functional>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace Shiny {
 
+/**
+ * Type-erased callable that is always stored inline (never allocates). Callables larger than kCapacity are rejected at
+ * compile time.
+ */
+template<typename RetType, typename... Params>
+class InlineFunction {
+public:
+   static const std::size_t kCapacity = 4 * sizeof(void*);
+
+   InlineFunction()
+      : ops(nullptr) {
+   }
+
+   template<typename Function, typename = typename std::enable_if<!std::is_same<typename std::decay<Function>::type, InlineFunction>::value>::type>
+   InlineFunction(Function&& function)
+      : ops(getOps<typename std::decay<Function>::type>()) {
+      using StoredType = typename std::decay<Function>::type;
+      static_assert(sizeof(StoredType) <= kCapacity, "Callable too large to store inline, try capturing less (e.g. a single pointer)");
+      static_assert(alignof(StoredType) <= alignof(Storage), "Callable alignment too large to store inline");
+
+      new (&storage) StoredType(std::forward<Function>(function));
+   }
+
+   InlineFunction(const InlineFunction& other) = delete;
+
+   InlineFunction(InlineFunction&& other)
+      : ops(other.ops) {
+      if (ops) {
+         ops->move(&storage, &other.storage);
+         other.reset();
+      }
+   }
+
+   ~InlineFunction() {
+      reset();
+   }
+
+   InlineFunction& operator=(const InlineFunction& other) = delete;
+
+   InlineFunction& operator=(InlineFunction&& other) {
+      if (this != &other) {
+         reset();
+
+         ops = other.ops;
+         if (ops) {
+            ops->move(&storage, &other.storage);
+            other.reset();
+         }
+      }
+
+      return *this;
+   }
+
+   explicit operator bool() const {
+      return ops != nullptr;
+   }
+
+   RetType operator()(Params... params) {
+      ASSERT(ops, "Trying to call empty function");
+      return ops->invoke(&storage, std::forward<Params>(params)...);
+   }
+
+   void reset() {
+      if (ops) {
+         ops->destroy(&storage);
+         ops = nullptr;
+      }
+   }
+
+private:
+   using Storage = typename std::aligned_storage<kCapacity, alignof(std::max_align_t)>::type;
+
+   struct Ops {
+      RetType (*invoke)(void* storage, Params... params);
+      void (*move)(void* to, void* from);
+      void (*destroy)(void* storage);
+   };
+
+   template<typename T>
+   static const Ops* getOps() {
+      static const Ops kOps = {
+         [](void* storage, Params... params) -> RetType {
+            return (*static_cast<T*>(storage))(std::forward<Params>(params)...);
+         },
+         [](void* to, void* from) {
+            new (to) T(std::move(*static_cast<T*>(from)));
+         },
+         [](void* storage) {
+            static_cast<T*>(storage)->~T();
+         }
+      };
+
+      return &kOps;
+   }
+
+   Storage storage;
+   const Ops* ops;
+};
+
+/**
+ * Multicast callback list. Bound functions are stored inline and stay bound for as long as the returned Handle lives.
+ * Handles and delegates point at each other (no reference counting), so firing never allocates or touches atomics.
+ * Unbinding only marks the binding as dead - dead bindings are purged lazily, by the next bind or execute.
+ * Not thread safe.
+ */
 template<typename RetType, typename... Params>
 class Delegate {
 public:
    using ReturnType = RetType;
-   using FuncType = std::function<ReturnType(Params...)>;
+   using FuncType = InlineFunction<ReturnType, Params...>;
 
-   class HandleData {
+   class Handle {
    public:
-      HandleData(const FuncType& inFunc = {})
-         : func(inFunc) {
+      Handle()
+         : delegate(nullptr), index(0) {
+      }
+
+      Handle(const Handle& other) = delete;
+
+      Handle(Handle&& other)
+         : delegate(other.delegate), index(other.index) {
+         if (delegate) {
+            delegate->getBinding(index).handle = this;
+            other.delegate = nullptr;
+         }
+      }
+
+      ~Handle() {
+         unbind();
+      }
+
+      Handle& operator=(const Handle& other) = delete;
+
+      Handle& operator=(Handle&& other) {
+         if (this != &other) {
+            unbind();
+
+            delegate = other.delegate;
+            index = other.index;
+            if (delegate) {
+               delegate->getBinding(index).handle = this;
+               other.delegate = nullptr;
+            }
+         }
+
+         return *this;
+      }
+
+      bool isBound() const {
+         return delegate != nullptr;
+      }
+
+      void unbind() {
+         if (delegate) {
+            delegate->unbind(index);
+            delegate = nullptr;
+         }
       }
-      HandleData(const HandleData& other) = delete;
-      HandleData(HandleData&& other) = delete;
-      ~HandleData() = default;
-      HandleData& operator=(const HandleData& other) = delete;
-      HandleData& operator=(HandleData&& other) = delete;
 
    private:
       friend class Delegate;
-      FuncType func;
+
+      Handle(Delegate* inDelegate, std::size_t inIndex)
+         : delegate(inDelegate), index(inIndex) {
+      }
+
+      Delegate* delegate;
+      std::size_t index;
    };
 
-   using Handle = SPtr<HandleData>;
-   using Binding = WPtr<HandleData>;
+   Delegate()
+      : executeDepth(0), numUnbound(0) {
+   }
+
+   Delegate(const Delegate& other) = delete;
+   Delegate(Delegate&& other) = delete;
+
+   ~Delegate() {
+      ASSERT(executeDepth == 0, "Destroying delegate while it is executing");
+
+      for (Binding& binding : bindings) {
+         if (binding.handle) {
+            binding.handle->delegate = nullptr;
+         }
+      }
+      for (Binding& binding : pendingBindings) {
+         if (binding.handle) {
+            binding.handle->delegate = nullptr;
+         }
+      }
+   }
+
+   Delegate& operator=(const Delegate& other) = delete;
+   Delegate& operator=(Delegate&& other) = delete;
+
+   template<typename Function>
+   Handle bind(Function&& function) {
+      if (executeDepth == 0) {
+         purgeUnbound();
+      }
+
+      // While executing, new bindings are kept aside so that the bindings being iterated never relocate
+      std::vector<Binding>& targetBindings = executeDepth > 0 ? pendingBindings : bindings;
+      std::size_t index = bindings.size() + pendingBindings.size();
+
+      targetBindings.push_back(Binding(FuncType(std::forward<Function>(function))));
 
-   Handle bind(const FuncType& function) {
-      Handle handle = std::make_shared<HandleData>(function);
-      bindings.push_back(Binding(handle));
+      Handle handle(this, index);
+      targetBindings.back().handle = &handle;
       return handle;
    }
 
    void execute(Params... params) {
-      purgeUnbound();
+      ExecuteScope scope(*this);
 
-      for (const Binding& binding : bindings) {
-         Handle handle = binding.lock();
-         ASSERT(handle);
-         handle->func(params...);
+      // Bindings added during execution are not called until the next execute
+      for (std::size_t i = 0; i < bindings.size(); ++i) {
+         if (bindings[i].handle) {
+            bindings[i].function(params...);
+         }
       }
    }
 
-   std::vector<ReturnType> executeWithReturn(Params... params) {
-      purgeUnbound();
-
-      std::vector<ReturnType> returnValues(bindings.size());
+   /**
+    * Executes all bindings, passing each return value to the visitor
+    */
+   template<typename Visitor>
+   void executeWithVisitor(Visitor&& visitor, Params... params) {
+      ExecuteScope scope(*this);
 
-      std::size_t index = 0;
-      for (const Binding& binding : bindings) {
-         Handle handle = binding.lock();
-         ASSERT(handle);
-         returnValues[index++] = handle->func(params...);
+      for (std::size_t i = 0; i < bindings.size(); ++i) {
+         if (bindings[i].handle) {
+            visitor(bindings[i].function(params...));
+         }
       }
+   }
 
-      return returnValues;
+   /**
+    * Executes all bindings, writing up to maxReturnValues return values to the given array. Returns the number written.
+    */
+   std::size_t executeWithReturn(ReturnType* returnValues, std::size_t maxReturnValues, Params... params) {
+      std::size_t numReturnValues = 0;
+      executeWithVisitor([returnValues, maxReturnValues, &numReturnValues](ReturnType returnValue) {
+         if (numReturnValues < maxReturnValues) {
+            returnValues[numReturnValues++] = std::move(returnValue);
+         }
+      }, params...);
+
+      return numReturnValues;
    }
 
 private:
+   struct Binding {
+      Binding(FuncType&& inFunction)
+         : function(std::move(inFunction)), handle(nullptr) {
+      }
+
+      FuncType function;
+      Handle* handle;
+   };
+
+   class ExecuteScope {
+   public:
+      ExecuteScope(Delegate& inDelegate)
+         : delegate(inDelegate) {
+         if (delegate.executeDepth++ == 0) {
+            delegate.purgeUnbound();
+         }
+      }
+
+      ~ExecuteScope() {
+         if (--delegate.executeDepth == 0) {
+            delegate.onExecuteFinished();
+         }
+      }
+
+   private:
+      Delegate& delegate;
+   };
+
+   Binding& getBinding(std::size_t index) {
+      return index < bindings.size() ? bindings[index] : pendingBindings[index - bindings.size()];
+   }
+
+   void unbind(std::size_t index) {
+      getBinding(index).handle = nullptr;
+      ++numUnbound;
+   }
+
+   void onExecuteFinished() {
+      for (Binding& binding : pendingBindings) {
+         bindings.push_back(std::move(binding));
+      }
+      pendingBindings.clear();
+
+      purgeUnbound();
+   }
+
    void purgeUnbound() {
-      bindings.erase(std::remove_if(bindings.begin(), bindings.end(), [](const Binding& binding) { return binding.expired(); }), bindings.end());
+      ASSERT(executeDepth <= 1, "Trying to purge bindings while they are being iterated");
+
+      if (numUnbound == 0) {
+         return;
+      }
+
+      std::size_t numLive = 0;
+      for (std::size_t i = 0; i < bindings.size(); ++i) {
+         if (bindings[i].handle) {
+            if (i != numLive) {
+               bindings[numLive] = std::move(bindings[i]);
+            }
+            bindings[numLive].handle->index = numLive;
+            ++numLive;
+         }
+      }
+
+      bindings.erase(bindings.begin() + numLive, bindings.end());
+      numUnbound = 0;
    }
 
    std::vector<Binding> bindings;
+   std::vector<Binding> pendingBindings;
+   std::size_t executeDepth;
+   std::size_t numUnbound;
 };
 
 } // namespace Shiny
@@ -4,16 +4,27 @@
 #include "Shiny/Pointers.h"
 #include "Shiny/ShinyAssert.h"
 #include "Shiny/Entity/Component.h"
+#include "Shiny/Entity/ComponentType.h"
 #include "Shiny/Entity/Delegate.h"
+#include "Shiny/Entity/EntityHandle.h"
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace Shiny {
 
 class Scene;
 
+/**
+ * Game-defined tag / layer bits, which views can filter on
+ */
+using EntityTagMask = std::uint32_t;
+
 class Entity {
 public:
    using OnDestroyDelegate = Delegate<void, Entity*>;
@@ -30,91 +41,162 @@ public:
 
    template<typename T>
    T* createComponent() {
-      components.push_back(ComponentRegistry::instance().createComponent<T>(*this));
-
-      T* newComponent = static_cast<T*>(components.back().get());
+      T* newComponent = constructComponent<T>();
       onComponentCreated(newComponent);
       return newComponent;
    }
 
    Component* createComponentByName(const std::string& className) {
-      UPtr<Component> newComponent = ComponentRegistry::instance().createComponent(*this, className);
+      Component* newComponent = constructComponentByName(className);
       if (!newComponent) {
          return nullptr;
       }
 
-      Component* newComponentRaw = newComponent.get();
-      components.push_back(std::move(newComponent));
-      onComponentCreated(newComponentRaw);
-      return newComponentRaw;
+      onComponentCreated(newComponent);
+      return newComponent;
+   }
+
+   template<typename T>
+   bool hasComponentOfClass() const {
+      return (componentTypeMask & ComponentTypeInfo<T>::mask()) != 0;
    }
 
    template<typename T>
    T* getComponentByClass() {
-      for (const UPtr<Component>& component : components) {
-         if (T* castedComponent = dynamic_cast<T*>(component.get())) {
-            return castedComponent;
-         }
+      if (!hasComponentOfClass<T>()) {
+         return nullptr;
       }
 
-      return nullptr;
+      return static_cast<T*>(components[firstComponentIndices[ComponentTypeInfo<T>::id()]].component);
    }
 
    template<typename T>
    const T* getComponentByClass() const {
-      for (const UPtr<Component>& component : components) {
-         if (const T* castedComponent = dynamic_cast<const T*>(component.get())) {
-            return castedComponent;
-         }
+      if (!hasComponentOfClass<T>()) {
+         return nullptr;
       }
 
-      return nullptr;
+      return static_cast<const T*>(components[firstComponentIndices[ComponentTypeInfo<T>::id()]].component);
    }
 
-   template<typename T>
-   std::vector<T*> getComponentsByClass() {
-      std::vector<T*> componentsOfClass;
+   /**
+    * Calls the given function with every component that is a T (including subclasses of T), without allocating
+    */
+   template<typename T, typename Function>
+   void forEachComponentOfClass(Function&& function) {
+      if (!hasComponentOfClass<T>()) {
+         return;
+      }
+
+      ComponentTypeMask mask = ComponentTypeInfo<T>::mask();
+      for (std::size_t i = firstComponentIndices[ComponentTypeInfo<T>::id()]; i < components.size(); ++i) {
+         if (components[i].typeMask & mask) {
+            function(static_cast<T*>(components[i].component));
+         }
+      }
+   }
+
+   template<typename T, typename Function>
+   void forEachComponentOfClass(Function&& function) const {
+      if (!hasComponentOfClass<T>()) {
+         return;
+      }
 
-      for (const UPtr<Component>& component : components) {
-         if (T* castedComponent = dynamic_cast<T*>(component.get())) {
-            componentsOfClass.push_back(castedComponent);
+      ComponentTypeMask mask = ComponentTypeInfo<T>::mask();
+      for (std::size_t i = firstComponentIndices[ComponentTypeInfo<T>::id()]; i < components.size(); ++i) {
+         if (components[i].typeMask & mask) {
+            function(static_cast<const T*>(components[i].component));
          }
       }
+   }
+
+   /**
+    * Appends every component that is a T to the given vector, allowing callers to reuse its storage between calls
+    */
+   template<typename T>
+   void getComponentsByClass(std::vector<T*>& componentsOfClass) {
+      forEachComponentOfClass<T>([&componentsOfClass](T* component) {
+         componentsOfClass.push_back(component);
+      });
+   }
 
+   template<typename T>
+   void getComponentsByClass(std::vector<const T*>& componentsOfClass) const {
+      forEachComponentOfClass<T>([&componentsOfClass](const T* component) {
+         componentsOfClass.push_back(component);
+      });
+   }
+
+   template<typename T>
+   std::vector<T*> getComponentsByClass() {
+      std::vector<T*> componentsOfClass;
+      getComponentsByClass<T>(componentsOfClass);
       return componentsOfClass;
    }
 
    template<typename T>
    std::vector<const T*> getComponentsByClass() const {
       std::vector<const T*> componentsOfClass;
-
-      for (const UPtr<Component>& component : components) {
-         if (const T* castedComponent = dynamic_cast<const T*>(component.get())) {
-            componentsOfClass.push_back(castedComponent);
-         }
-      }
-
+      getComponentsByClass<T>(componentsOfClass);
       return componentsOfClass;
    }
 
    void destroy();
 
-   OnDestroyDelegate::Handle bindOnDestroy(const OnDestroyDelegate::FuncType& function) {
-      return onDestroy.bind(function);
+   template<typename Function>
+   OnDestroyDelegate::Handle bindOnDestroy(Function&& function) {
+      return onDestroy.bind(std::forward<Function>(function));
    }
 
    bool destroyComponent(Component* componentToDestroy) {
-      auto itr = std::find_if(components.begin(), components.end(), [componentToDestroy](const UPtr<Component>& component) { return component.get() == componentToDestroy; });
+      auto itr = std::find_if(components.begin(), components.end(), [componentToDestroy](const ComponentEntry& entry) { return entry.component == componentToDestroy; });
 
       if (itr != components.end()) {
-         (*itr)->executeDestroy();
+         ComponentEntry entry = *itr;
+         entry.component->executeDestroy();
          components.erase(itr);
+         rebuildComponentTypeTable();
+
+         entry.storage->destroy(entry.slot);
+
+         onSignatureChanged();
          return true;
       }
 
       return false;
    }
 
+   EntityTagMask getTags() const {
+      return tags;
+   }
+
+   bool hasTags(EntityTagMask tagsToCheck) const {
+      return (tags & tagsToCheck) == tagsToCheck;
+   }
+
+   void setTags(EntityTagMask newTags) {
+      if (newTags != tags) {
+         tags = newTags;
+         onSignatureChanged();
+      }
+   }
+
+   void addTags(EntityTagMask tagsToAdd) {
+      setTags(tags | tagsToAdd);
+   }
+
+   void removeTags(EntityTagMask tagsToRemove) {
+      setTags(tags & ~tagsToRemove);
+   }
+
+   ComponentTypeMask getComponentTypeMask() const {
+      return componentTypeMask;
+   }
+
+   EntityHandle getHandle() const {
+      return handle;
+   }
+
    Scene& getScene() {
       return scene;
    }
@@ -126,9 +208,18 @@ public:
 private:
    friend class Scene;
 
+   struct ComponentEntry {
+      Component* component;
+      ComponentStorageBase* storage;
+      ComponentStorageBase::Slot slot;
+      ComponentTypeMask typeMask;
+   };
+
+   using ComponentIndex = std::uint16_t;
+
    template<typename... ComponentTypes>
-   static UPtr<Entity> create(Scene& scene) {
-      UPtr<Entity> entity(new Entity(scene));
+   static UPtr<Entity> create(Scene& scene, ComponentStore& componentStore, EntityHandle handle) {
+      UPtr<Entity> entity(new Entity(scene, componentStore, handle));
 
       entity->constructComponents<ComponentTypes...>();
       entity->onInitialized();
@@ -136,27 +227,77 @@ private:
       return entity;
    }
 
-   static UPtr<Entity> create(const std::vector<std::string>& componentClassNames, Scene& scene) {
-      UPtr<Entity> entity(new Entity(scene));
+   static UPtr<Entity> create(const std::vector<std::string>& componentClassNames, Scene& scene, ComponentStore& componentStore, EntityHandle handle) {
+      UPtr<Entity> entity(new Entity(scene, componentStore, handle));
 
       for (const std::string& className : componentClassNames) {
-         UPtr<Component> newComponent = ComponentRegistry::instance().createComponent(*entity, className);
-         if (newComponent) {
-            entity->components.push_back(std::move(newComponent));
-         }
+         entity->constructComponentByName(className);
       }
       entity->onInitialized();
 
       return entity;
    }
 
-   Entity(Scene& inScene)
-      : scene(inScene) {
+   Entity(Scene& inScene, ComponentStore& inComponentStore, EntityHandle inHandle)
+      : scene(inScene), componentStore(inComponentStore), handle(inHandle), tags(0), componentTypeMask(0), firstComponentIndices{} {
+   }
+
+   template<typename T>
+   T* constructComponent() {
+      ComponentStorage<T>& storage = componentStore.getStorage<T>();
+      ComponentStorageBase::Slot slot = storage.create(*this);
+
+      T* newComponent = storage.get(slot);
+      addComponentEntry({ newComponent, &storage, slot, storage.getTypeMask() });
+      return newComponent;
+   }
+
+   Component* constructComponentByName(const std::string& className) {
+      ComponentStorageBase* storage = ComponentRegistry::instance().getStorage(componentStore, className);
+      if (!storage) {
+         return nullptr;
+      }
+
+      return constructComponent(*storage);
+   }
+
+   Component* constructComponent(ComponentStorageBase& storage) {
+      ComponentStorageBase::Slot slot = storage.create(*this);
+
+      Component* newComponent = storage.getComponent(slot);
+      addComponentEntry({ newComponent, &storage, slot, storage.getTypeMask() });
+      return newComponent;
+   }
+
+   void addComponentEntry(const ComponentEntry& entry) {
+      ASSERT(components.size() < std::numeric_limits<ComponentIndex>::max(), "Too many components in entity");
+
+      components.push_back(entry);
+      addToComponentTypeTable(static_cast<ComponentIndex>(components.size() - 1));
+   }
+
+   void addToComponentTypeTable(ComponentIndex index) {
+      // Only types that aren't already present are updated, so the table always refers to the first matching component
+      ComponentTypeMask newTypes = components[index].typeMask & ~componentTypeMask;
+      for (ComponentTypeId typeId = 0; newTypes != 0; ++typeId, newTypes >>= 1) {
+         if (newTypes & 1) {
+            firstComponentIndices[typeId] = index;
+         }
+      }
+
+      componentTypeMask |= components[index].typeMask;
+   }
+
+   void rebuildComponentTypeTable() {
+      componentTypeMask = 0;
+      for (std::size_t i = 0; i < components.size(); ++i) {
+         addToComponentTypeTable(static_cast<ComponentIndex>(i));
+      }
    }
 
    template<typename First, typename... Rest>
    void constructComponentsHelper() {
-      components.push_back(ComponentRegistry::instance().createComponent<First>(*this));
+      constructComponent<First>();
       constructComponents<Rest...>();
    }
 
@@ -166,28 +307,47 @@ private:
    }
 
    void onInitialized() {
-      for (const UPtr<Component>& component : components) {
-         component->onOwnerInitialized();
+      for (const ComponentEntry& entry : components) {
+         entry.component->onOwnerInitialized();
       }
    }
 
    void onComponentCreated(Component* component) {
-      for (const UPtr<Component>& component : components) {
-         component->onComponentAddedToOwner(component.get());
+      for (const ComponentEntry& entry : components) {
+         entry.component->onComponentAddedToOwner(component);
       }
+
+      onSignatureChanged();
    }
 
+   /**
+    * Lets the scene update its cached views after the entity's component types or tags change
+    */
+   void onSignatureChanged();
+
    void executeDestroy() {
-      for (const auto& component : components) {
-         component->executeDestroy();
+      for (const ComponentEntry& entry : components) {
+         entry.component->executeDestroy();
+      }
+      for (const ComponentEntry& entry : components) {
+         entry.storage->destroy(entry.slot);
       }
       components.clear();
+      componentTypeMask = 0;
 
       onDestroy.execute(this);
    }
 
-   std::vector<UPtr<Component>> components;
+   std::vector<ComponentEntry> components;
    Scene& scene;
+   ComponentStore& componentStore;
+   const EntityHandle handle;
+   EntityTagMask tags;
+
+   // Bitmask of all component types (including superclasses) present on the entity, and the index of the first
+   // component of each present type
+   ComponentTypeMask componentTypeMask;
+   std::array<ComponentIndex, kMaxComponentTypes> firstComponentIndices;
    OnDestroyDelegate onDestroy;
 };
 
@@ -0,0 +1,46 @@
+#ifndef SHINY_ENTITY_HANDLE_H
+#define SHINY_ENTITY_HANDLE_H
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+
+namespace Shiny {
+
+/**
+ * Weak reference to an entity in a scene. The generation is bumped every time the slot at the given index is reused,
+ * so handles to destroyed entities can be detected instead of dangling.
+ */
+struct EntityHandle {
+   static const std::uint32_t kInvalidIndex = std::numeric_limits<std::uint32_t>::max();
+
+   EntityHandle(std::uint32_t inIndex = kInvalidIndex, std::uint32_t inGeneration = 0)
+      : index(inIndex), generation(inGeneration) {
+   }
+
+   bool operator==(const EntityHandle& other) const {
+      return index == other.index && generation == other.generation;
+   }
+
+   bool operator!=(const EntityHandle& other) const {
+      return !(*this == other);
+   }
+
+   std::uint32_t index;
+   std::uint32_t generation;
+};
+
+} // namespace Shiny
+
+namespace std {
+
+template<>
+struct hash<Shiny::EntityHandle> {
+   std::size_t operator()(const Shiny::EntityHandle& handle) const {
+      return hash<std::uint64_t>()((static_cast<std::uint64_t>(handle.generation) << 32) | handle.index);
+   }
+};
+
+} // namespace std
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef SHINY_PREFAB_H
+#define SHINY_PREFAB_H
+
+#include "Shiny/ShinyAssert.h"
+#include "Shiny/Entity/Component.h"
+#include "Shiny/Entity/ComponentStorage.h"
+#include "Shiny/Entity/ComponentType.h"
+#include "Shiny/Entity/Entity.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Shiny {
+
+/**
+ * Precompiled entity description: an ordered list of component types (resolved once, when the prefab is built), the
+ * initial values of each component (applied by an init function), and the entity's tags. Used with
+ * Scene::instantiate() to spawn many identical entities in bulk.
+ *
+ * Prefab prefab;
+ * prefab.add<TransformComponent>().add<PointLightComponent>([](PointLightComponent& light) { light.setColor(glm::vec3(1.0f, 0.0f, 0.0f)); });
+ */
+class Prefab {
+public:
+   template<typename T>
+   using ComponentInitFunc = std::function<void(T&)>;
+
+   Prefab()
+      : tags(0) {
+   }
+
+   template<typename T>
+   Prefab& add(const ComponentInitFunc<T>& initFunction = nullptr) {
+      ComponentEntry entry;
+      entry.typeId = ComponentTypeInfo<T>::id();
+      entry.createStorageFunc = &ComponentStorage<T>::createStorage;
+
+      if (initFunction) {
+         entry.initFunction = [initFunction](Component& component) {
+            initFunction(static_cast<T&>(component));
+         };
+      }
+
+      components.push_back(std::move(entry));
+      return *this;
+   }
+
+   Prefab& add(const std::string& className, const ComponentInitFunc<Component>& initFunction = nullptr) {
+      ComponentEntry entry;
+      bool found = ComponentRegistry::instance().getComponentType(className, entry.typeId, entry.createStorageFunc);
+      ASSERT(found, "Trying to add unregistered component class to prefab: %s", className.c_str());
+
+      if (found) {
+         entry.initFunction = initFunction;
+         components.push_back(std::move(entry));
+      }
+
+      return *this;
+   }
+
+   Prefab& setTags(EntityTagMask newTags) {
+      tags = newTags;
+      return *this;
+   }
+
+   EntityTagMask getTags() const {
+      return tags;
+   }
+
+   std::size_t getNumComponents() const {
+      return components.size();
+   }
+
+private:
+   friend class Scene;
+
+   struct ComponentEntry {
+      ComponentTypeId typeId;
+      ComponentStore::CreateStorageFunc createStorageFunc;
+      std::function<void(Component&)> initFunction;
+   };
+
+   std::vector<ComponentEntry> components;
+   EntityTagMask tags;
+};
+
+} // namespace Shiny
+
+#endif
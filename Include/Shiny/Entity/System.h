@@ -0,0 +1,79 @@
+#ifndef SHINY_SYSTEM_H
+#define SHINY_SYSTEM_H
+
+#include "Shiny/Entity/ComponentType.h"
+
+namespace Shiny {
+
+class Scene;
+class ThreadPool;
+
+/**
+ * Component types accessed by a system. Both the exact type bits and the ancestor bits are kept, so that accessing a
+ * component class also conflicts with accessing its superclasses and subclasses.
+ */
+struct ComponentAccess {
+   ComponentTypeMask typeMask = 0;
+   ComponentTypeMask ancestorMask = 0;
+
+   template<typename T>
+   void add() {
+      typeMask |= ComponentTypeInfo<T>::mask();
+      ancestorMask |= ComponentTypeInfo<T>::ancestorMask();
+   }
+
+   bool overlaps(const ComponentAccess& other) const {
+      return (ancestorMask & other.typeMask) != 0 || (other.ancestorMask & typeMask) != 0;
+   }
+};
+
+/**
+ * A unit of per-frame game logic. Systems declare (in their constructor) which component types they read and write,
+ * which the SystemScheduler uses to run non-conflicting systems concurrently. Systems must not create or destroy
+ * entities / components directly while updating - structural changes go through the scene's SceneCommandBuffer. Scene
+ * views are safe to create while updating (views are only kept up to date at the sync point, where the command buffer
+ * is flushed).
+ */
+class System {
+public:
+   virtual ~System() = default;
+
+   virtual void update(Scene& scene, float dt, ThreadPool& threadPool) = 0;
+
+   const ComponentAccess& getReadAccess() const {
+      return readAccess;
+   }
+
+   const ComponentAccess& getWriteAccess() const {
+      return writeAccess;
+   }
+
+   bool conflictsWith(const System& other) const {
+      return writeAccess.overlaps(other.writeAccess) || writeAccess.overlaps(other.readAccess) || readAccess.overlaps(other.writeAccess);
+   }
+
+protected:
+   template<typename... ComponentTypes>
+   void reads() {
+      addAccess<ComponentTypes...>(readAccess);
+   }
+
+   template<typename... ComponentTypes>
+   void writes() {
+      addAccess<ComponentTypes...>(writeAccess);
+   }
+
+private:
+   template<typename... ComponentTypes>
+   static void addAccess(ComponentAccess& access) {
+      int dummy[] = { 0, (access.add<ComponentTypes>(), 0)... };
+      (void)dummy;
+   }
+
+   ComponentAccess readAccess;
+   ComponentAccess writeAccess;
+};
+
+} // namespace Shiny
+
+#endif
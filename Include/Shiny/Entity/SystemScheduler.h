@@ -0,0 +1,68 @@
+#ifndef SHINY_SYSTEM_SCHEDULER_H
+#define SHINY_SYSTEM_SCHEDULER_H
+
+#include "Shiny/Pointers.h"
+#include "Shiny/Entity/System.h"
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace Shiny {
+
+class Scene;
+class ThreadPool;
+
+/**
+ * Runs systems on a thread pool. Systems that conflict (one writes a component type that the other reads or writes)
+ * run in the order they were added; all others may run concurrently.
+ */
+class SystemScheduler {
+public:
+   SystemScheduler(ThreadPool& inThreadPool)
+      : threadPool(inThreadPool), graphDirty(false) {
+   }
+
+   SystemScheduler(const SystemScheduler& other) = delete;
+   SystemScheduler(SystemScheduler&& other) = delete;
+   SystemScheduler& operator=(const SystemScheduler& other) = delete;
+   SystemScheduler& operator=(SystemScheduler&& other) = delete;
+
+   template<typename T, typename... Args>
+   T* addSystem(Args&&... args) {
+      T* system = new T(std::forward<Args>(args)...);
+      addSystem(UPtr<System>(system));
+      return system;
+   }
+
+   void addSystem(UPtr<System> system);
+
+   bool removeSystem(System* system);
+
+   /**
+    * Runs all systems to completion, then flushes the scene's command buffer (the frame's structural sync point)
+    */
+   void run(Scene& scene, float dt);
+
+private:
+   struct SystemNode {
+      UPtr<System> system;
+      std::vector<std::size_t> dependents;
+      std::size_t numDependencies = 0;
+   };
+
+   struct RunState;
+
+   void buildGraph();
+
+   static bool runReadySystem(const std::weak_ptr<RunState>& weakState);
+
+   ThreadPool& threadPool;
+   std::vector<SystemNode> nodes;
+   bool graphDirty;
+};
+
+} // namespace Shiny
+
+#endif
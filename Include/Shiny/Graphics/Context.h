@@ -2,16 +2,35 @@
 #define SHINY_CONTEXT_H
 
 #include "Shiny/ShinyAssert.h"
+#include "Shiny/Graphics/FrameStats.h"
+#include "Shiny/Graphics/GpuProfiler.h"
 #include "Shiny/Graphics/OpenGL.h"
 #include "Shiny/Graphics/TextureInfo.h"
 #include "Shiny/Graphics/Viewport.h"
 
 #include <array>
+#include <cstddef>
+#include <functional>
 
 namespace Shiny {
 
+/**
+ * Shadows the GL state the engine changes, so that redundant calls can be skipped. All engine code changes that state
+ * through the context (call poll() after changing it directly).
+ */
 class Context {
 public:
+   // Texture units (and sampler bindings) that are tracked
+   static const GLuint kMaxTextureUnits = 32;
+
+   // Number of frames getAverageFrameStats() averages over
+   static const std::size_t kFrameStatsHistorySize = 60;
+
+   /**
+    * Called by endFrame() with the stats of the frame that just ended, e.g. to draw a text overlay with toString()
+    */
+   using FrameStatsHook = std::function<void(const FrameStats& lastFrameStats, const AverageFrameStats& averageFrameStats)>;
+
    static Context* current() {
       ASSERT(currentContext, "Current context is null");
       return currentContext;
@@ -38,10 +57,141 @@ public:
 
    void useProgram(GLuint program);
    void bindVertexArray(GLuint vao);
-   void bindTexture(Tex::Target target, GLuint texture);
    void bindFramebuffer(GLuint fbo);
+   void bindDrawFramebuffer(GLuint fbo);
+   void bindReadFramebuffer(GLuint fbo);
+
+   /**
+    * Selects the texture unit (an index, not GL_TEXTURE0 + index) that bindTexture() binds to
+    */
+   void activeTexture(GLint unit);
+   void bindTexture(Tex::Target target, GLuint texture);
+   void bindSampler(GLint unit, GLuint sampler);
+
+   /**
+    * Generic binding points of GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER (which is part of the bound VAO's state),
+    * GL_UNIFORM_BUFFER or GL_TEXTURE_BUFFER. The indexed versions are always issued, and also set the generic binding.
+    */
+   void bindBuffer(GLenum target, GLuint buffer);
+   void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+   void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
 
+   /**
+    * GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST or GL_SCISSOR_TEST
+    */
+   void setEnabled(GLenum capability, bool enabled);
+   bool isEnabled(GLenum capability) const;
+
+   void enable(GLenum capability) {
+      setEnabled(capability, true);
+   }
+
+   void disable(GLenum capability) {
+      setEnabled(capability, false);
+   }
+
+   void setDepthFunc(GLenum func);
+   void setDepthMask(bool mask);
+   void setBlendFunc(GLenum sourceFactor, GLenum destinationFactor);
+   void setCullFace(GLenum face);
+   void setScissor(const Viewport& box);
+
+   GLenum getDepthFunc() const {
+      return depthFunc;
+   }
+
+   bool getDepthMask() const {
+      return depthMask;
+   }
+
+   GLenum getBlendSourceFactor() const {
+      return blendSourceFactor;
+   }
+
+   GLenum getBlendDestinationFactor() const {
+      return blendDestinationFactor;
+   }
+
+   GLenum getCullFace() const {
+      return cullFace;
+   }
+
+   // Deleted objects are unbound by GL, and their names can be reused
    void onFramebufferDeleted(GLuint fbo);
+   void onVertexArrayDeleted(GLuint vao);
+   void onTextureDeleted(GLuint texture);
+   void onSamplerDeleted(GLuint sampler);
+   void onBufferDeleted(GLuint buffer);
+
+#if SHINY_DEBUG
+   /**
+    * When enabled, the cached state is compared with glGet*() before every draw (slow - for tracking down GL calls that
+    * bypass the context)
+    */
+   void setValidationEnabled(bool enabled) {
+      validationEnabled = enabled;
+   }
+
+   /**
+    * Asserts that the cached state matches the actual GL state
+    */
+   void validate();
+#endif // SHINY_DEBUG
+
+   void onDraw(GLsizei numInstances) {
+#if SHINY_DEBUG
+      if (validationEnabled) {
+         validate();
+      }
+#endif // SHINY_DEBUG
+
+      ++frameStats.drawCalls;
+      frameStats.drawnInstances += numInstances;
+   }
+
+   void onUniformUploads(std::size_t numUniforms) {
+      frameStats.uniformUploads += numUniforms;
+   }
+
+   void onBufferUpload(std::size_t numBytes) {
+      ++frameStats.bufferUploads;
+      frameStats.bufferUploadBytes += numBytes;
+   }
+
+   /**
+    * Finishes counting the current frame. Should be called once per frame, before swapping buffers.
+    */
+   void endFrame();
+
+   /**
+    * Counters of the frame in progress
+    */
+   const FrameStats& getFrameStats() const {
+      return frameStats;
+   }
+
+   const FrameStats& getLastFrameStats() const {
+      return lastFrameStats;
+   }
+
+   /**
+    * Rolling averages over the last kFrameStatsHistorySize frames (or fewer, if fewer have ended)
+    */
+   AverageFrameStats getAverageFrameStats() const;
+
+   void setFrameStatsHook(const FrameStatsHook& hook) {
+      frameStatsHook = hook;
+   }
+
+#if SHINY_GPU_PROFILING
+   GpuProfiler& getGpuProfiler() {
+      return gpuProfiler;
+   }
+
+   const GpuProfiler& getGpuProfiler() const {
+      return gpuProfiler;
+   }
+#endif // SHINY_GPU_PROFILING
 
    Viewport getViewport() const {
       return viewport;
@@ -51,20 +201,60 @@ public:
       return maxTextureSize;
    }
 
+   GLint getUniformBufferOffsetAlignment() const {
+      return uniformBufferOffsetAlignment;
+   }
+
 private:
    static void setCurrent(Context *context);
    static void onDestroy(Context *context);
 
    static Context* currentContext;
 
+   static const std::size_t kNumTextureTargets = 10;
+   static const std::size_t kNumBufferTargets = 4;
+   static const std::size_t kNumCapabilities = 4;
+
+   // The element array buffer binding after a VAO change, until it is set
+   static const GLuint kUnknownBinding = static_cast<GLuint>(-1);
+
    Viewport viewport;
    GLuint currentProgram;
    GLuint boundVAO;
    GLuint boundDrawFBO;
    GLuint boundReadFBO;
-   std::array<GLuint, 10> boundTextures;
+
+   GLint numTextureUnits;
+   GLint activeTextureUnit;
+   std::array<std::array<GLuint, kNumTextureTargets>, kMaxTextureUnits> boundTextures;
+   std::array<GLuint, kMaxTextureUnits> boundSamplers;
+   std::array<GLuint, kNumBufferTargets> boundBuffers;
+
+   std::array<bool, kNumCapabilities> enabledCapabilities;
+   GLenum depthFunc;
+   bool depthMask;
+   GLenum blendSourceFactor;
+   GLenum blendDestinationFactor;
+   GLenum cullFace;
+   Viewport scissor;
+
+#if SHINY_DEBUG
+   bool validationEnabled;
+#endif // SHINY_DEBUG
 
    GLint maxTextureSize;
+   GLint uniformBufferOffsetAlignment;
+
+   FrameStats frameStats;
+   FrameStats lastFrameStats;
+   std::array<FrameStats, kFrameStatsHistorySize> frameStatsHistory;
+   std::size_t frameStatsHistoryIndex;
+   std::size_t numFrameStatsHistory;
+   FrameStatsHook frameStatsHook;
+
+#if SHINY_GPU_PROFILING
+   GpuProfiler gpuProfiler;
+#endif // SHINY_GPU_PROFILING
 };
 
 } // namespace Shiny
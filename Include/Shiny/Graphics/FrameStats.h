@@ -0,0 +1,52 @@
+#ifndef SHINY_FRAME_STATS_H
+#define SHINY_FRAME_STATS_H
+
+#include <cstdint>
+#include <string>
+
+namespace Shiny {
+
+// Every counter, with the label it is displayed with
+#define SHINY_FRAME_STATS_COUNTERS(counter)\
+   counter(drawCalls, "Draw calls")\
+   counter(drawnInstances, "Instances")\
+   counter(programSwitches, "Program switches")\
+   counter(vertexArrayBinds, "VAO binds")\
+   counter(textureBinds, "Texture binds")\
+   counter(framebufferBinds, "Framebuffer binds")\
+   counter(uniformUploads, "Uniform uploads")\
+   counter(bufferUploads, "Buffer uploads")\
+   counter(bufferUploadBytes, "Buffer upload bytes")
+
+/**
+ * GL work counted by the context over a frame. Only calls that reach GL are counted (binds skipped because the state is
+ * already current are free).
+ */
+template<typename T>
+struct BasicFrameStats {
+#define SHINY_DECLARE_FRAME_STATS_COUNTER(name, label) T name = 0;
+   SHINY_FRAME_STATS_COUNTERS(SHINY_DECLARE_FRAME_STATS_COUNTER)
+#undef SHINY_DECLARE_FRAME_STATS_COUNTER
+
+   /**
+    * Calls the function with the label and value of each counter
+    */
+   template<typename Function>
+   void forEach(Function&& function) const {
+#define SHINY_VISIT_FRAME_STATS_COUNTER(name, label) function(label, name);
+      SHINY_FRAME_STATS_COUNTERS(SHINY_VISIT_FRAME_STATS_COUNTER)
+#undef SHINY_VISIT_FRAME_STATS_COUNTER
+   }
+
+   /**
+    * One "label: value" line per counter, e.g. for a text overlay
+    */
+   std::string toString() const;
+};
+
+using FrameStats = BasicFrameStats<std::uint64_t>;
+using AverageFrameStats = BasicFrameStats<double>;
+
+} // namespace Shiny
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef SHINY_FRAME_UNIFORMS_H
+#define SHINY_FRAME_UNIFORMS_H
+
+#include "Shiny/Graphics/OpenGL.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+namespace Shiny {
+
+namespace FrameUniforms {
+
+const char* const kBlockName = "ShinyFrame";
+
+// Uniform buffer binding point the block is connected to when a program is linked
+const GLuint kBindingPoint = 0;
+
+const int kMaxLights = 16;
+
+enum LightType : GLint {
+   kAmbient = 0,
+   kDirectional = 1,
+   kPoint = 2,
+   kSpot = 3
+};
+
+} // namespace FrameUniforms
+
+namespace DrawUniforms {
+
+const char* const kBlockName = "ShinyDraw";
+
+// Binding point that ranges of recorded per-draw data are bound to (see RenderCommandList)
+const GLuint kBindingPoint = 1;
+
+} // namespace DrawUniforms
+
+/**
+ * std140 layout of the per-frame uniform block, shared by all shader programs that declare it:
+ *
+ * struct ShinyLight {
+ *    vec4 color;             // rgb = color, a = type
+ *    vec4 positionFalloff;   // xyz = world position, w = square falloff
+ *    vec4 directionBeam;     // xyz = world direction, w = beam angle
+ *    vec4 cutoff;            // x = cutoff angle
+ * };
+ *
+ * layout(std140) uniform ShinyFrame {
+ *    mat4 uViewMatrix;
+ *    mat4 uProjMatrix;
+ *    mat4 uViewProjMatrix;
+ *    vec4 uCameraPosition;
+ *    ivec4 uNumLights;       // x = number of lights
+ *    ShinyLight uLights[16];
+ * };
+ */
+struct FrameUniformData {
+   struct Light {
+      glm::vec4 color;
+      glm::vec4 positionFalloff;
+      glm::vec4 directionBeam;
+      glm::vec4 cutoff;
+   };
+
+   glm::mat4 viewMatrix;
+   glm::mat4 projMatrix;
+   glm::mat4 viewProjMatrix;
+   glm::vec4 cameraPosition;
+   glm::ivec4 numLights;
+   Light lights[FrameUniforms::kMaxLights];
+};
+
+static_assert(sizeof(FrameUniformData::Light) == 4 * sizeof(glm::vec4), "Light data doesn't match the std140 layout");
+static_assert(offsetof(FrameUniformData, lights) == 3 * sizeof(glm::mat4) + 2 * sizeof(glm::vec4), "Frame data doesn't match the std140 layout");
+
+/**
+ * std140 layout of the per-draw uniform block. Programs that declare it (instead of the uModelMatrix / uNormalMatrix
+ * uniforms) read their matrices from a range of a buffer written once per command list, rather than having uniforms
+ * set for every draw:
+ *
+ * layout(std140) uniform ShinyDraw {
+ *    mat4 uModelMatrix;
+ *    mat4 uNormalMatrix;
+ * };
+ */
+struct DrawUniformData {
+   glm::mat4 modelMatrix;
+   glm::mat4 normalMatrix;
+};
+
+/**
+ * Uniform buffer holding the ShinyFrame block, uploaded once per frame and bound to FrameUniforms::kBindingPoint
+ */
+class FrameUniformBuffer {
+public:
+   FrameUniformBuffer();
+   FrameUniformBuffer(const FrameUniformBuffer& other) = delete;
+   FrameUniformBuffer(FrameUniformBuffer&& other) = delete;
+
+   ~FrameUniformBuffer();
+
+   FrameUniformBuffer& operator=(const FrameUniformBuffer& other) = delete;
+   FrameUniformBuffer& operator=(FrameUniformBuffer&& other) = delete;
+
+   GLuint getID() const {
+      return id;
+   }
+
+   /**
+    * Uploads the data (only the lights in use) and binds the buffer to the frame binding point
+    */
+   void upload(const FrameUniformData& data);
+
+private:
+   GLuint id;
+};
+
+} // namespace Shiny
+
+#endif
@@ -44,6 +44,18 @@ public:
 
    void setResolution(GLsizei attachmentWidth, GLsizei attachmentHeight);
 
+   GLuint getId() const {
+      return fbo;
+   }
+
+   GLsizei getWidth() const {
+      return width;
+   }
+
+   GLsizei getHeight() const {
+      return height;
+   }
+
    /**
     * Causes all drawing to occur in the framebuffer
     */
@@ -0,0 +1,142 @@
+#ifndef SHINY_GPU_PROFILER_H
+#define SHINY_GPU_PROFILER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if SHINY_GPU_PROFILING
+#  include "Shiny/Graphics/OpenGL.h"
+
+#  include <array>
+#  include <cstddef>
+#endif // SHINY_GPU_PROFILING
+
+/**
+ * Times the GPU work issued until the end of the enclosing block, e.g. SHINY_GPU_SCOPE("Shadows"). The name must be a
+ * string literal (or otherwise outlive the frame). Compiles to nothing unless SHINY_GPU_PROFILING is enabled.
+ */
+#if SHINY_GPU_PROFILING
+#  define SHINY_GPU_SCOPE_CONCAT_IMPL(a, b) a##b
+#  define SHINY_GPU_SCOPE_CONCAT(a, b) SHINY_GPU_SCOPE_CONCAT_IMPL(a, b)
+#  define SHINY_GPU_SCOPE(name) Shiny::GpuScope SHINY_GPU_SCOPE_CONCAT(shinyGpuScope, __LINE__)(name)
+#else
+#  define SHINY_GPU_SCOPE(name) do {} while (0)
+#endif // SHINY_GPU_PROFILING
+
+namespace Shiny {
+
+/**
+ * GPU time spent in a named scope over a frame. Scopes with the same name and parent are merged.
+ */
+struct GpuScopeTiming {
+   std::string name;
+   double milliseconds = 0.0;
+   std::uint32_t count = 0;
+   std::vector<GpuScopeTiming> children;
+};
+
+struct GpuProfile {
+   // Frame the timings were recorded in (results arrive a few frames late)
+   std::uint64_t frame = 0;
+
+   // Whole frame (from the end of the previous frame), with the top level scopes as children
+   GpuScopeTiming root;
+};
+
+#if SHINY_GPU_PROFILING
+
+/**
+ * Records scopes with GL_TIMESTAMP queries (which, unlike GL_TIME_ELAPSED queries, can nest). Queries are kept for
+ * kFrameLatency frames, and a frame's results are only read once they are available, so profiling never stalls the
+ * pipeline. If the GPU falls further behind than that, the oldest frame's results are dropped.
+ */
+class GpuProfiler {
+public:
+   static const std::size_t kFrameLatency = 4;
+
+   GpuProfiler();
+   GpuProfiler(const GpuProfiler& other) = delete;
+   GpuProfiler(GpuProfiler&& other) = delete;
+
+   ~GpuProfiler();
+
+   GpuProfiler& operator=(const GpuProfiler& other) = delete;
+   GpuProfiler& operator=(GpuProfiler&& other) = delete;
+
+   void beginScope(const char* name);
+   void endScope();
+
+   /**
+    * Ends the current frame, and resolves the frames whose results have become available
+    */
+   void endFrame();
+
+   /**
+    * Most recently resolved frame
+    */
+   const GpuProfile& getProfile() const {
+      return profile;
+   }
+
+   std::uint64_t getNumDroppedFrames() const {
+      return numDroppedFrames;
+   }
+
+private:
+   static const std::size_t kNoParent = static_cast<std::size_t>(-1);
+
+   struct ScopeRecord {
+      const char* name;
+      std::size_t parent;
+      std::size_t beginQuery;
+      std::size_t endQuery;
+   };
+
+   struct FrameQueries {
+      // Query 0 marks the start of the frame
+      std::vector<GLuint> queries;
+      std::size_t numUsedQueries = 0;
+      std::vector<ScopeRecord> scopes;
+      std::uint64_t frame = 0;
+      bool pending = false;
+   };
+
+   std::size_t issueTimestamp(FrameQueries& frameQueries);
+   void beginFrame();
+   bool tryResolve(FrameQueries& frameQueries);
+
+   std::array<FrameQueries, kFrameLatency> frames;
+   std::size_t frameIndex;
+   std::uint64_t frame;
+   bool started;
+
+   std::vector<std::size_t> scopeStack;
+
+   GpuProfile profile;
+   std::uint64_t numDroppedFrames;
+};
+
+/**
+ * Times its lifetime with the current context's profiler (see SHINY_GPU_SCOPE)
+ */
+class GpuScope {
+public:
+   GpuScope(const char* name);
+   GpuScope(const GpuScope& other) = delete;
+   GpuScope(GpuScope&& other) = delete;
+
+   ~GpuScope();
+
+   GpuScope& operator=(const GpuScope& other) = delete;
+   GpuScope& operator=(GpuScope&& other) = delete;
+
+private:
+   GpuProfiler& profiler;
+};
+
+#endif // SHINY_GPU_PROFILING
+
+} // namespace Shiny
+
+#endif
@@ -2,6 +2,11 @@
 #define SHINY_MESH_H
 
 #include "Shiny/Graphics/OpenGL.h"
+#include "Shiny/Math/Bounds.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
 
 namespace Shiny {
 
@@ -10,14 +15,28 @@ public:
    static const unsigned int kDefaultDimensionality = 3;
    static const GLenum kDefaultUsage = GL_STATIC_DRAW;
 
+   /**
+    * Per-instance data read by instanced shader programs
+    */
+   struct InstanceData {
+      glm::mat4 modelMatrix;
+      glm::mat4 normalMatrix;
+   };
+
 protected:
    GLuint vbo { 0 };
    GLuint nbo { 0 };
    GLuint tbo { 0 };
    GLuint ibo { 0 };
    GLuint vao { 0 };
+   GLuint instanceBuffer { 0 };
 
    unsigned int numIndices { 0 };
+   std::size_t instanceBufferCapacity { 0 };
+
+   BoundingBox boundingBox;
+   BoundingSphere boundingSphere;
+   bool hasBounds { false };
 
    void release();
 
@@ -36,10 +55,45 @@ public:
 
    ~Mesh();
 
+   GLuint getVAO() const {
+      return vao;
+   }
+
    void bindVAO() const;
 
+   /**
+    * Whether local bounds have been provided (meshes without bounds are never culled)
+    */
+   bool hasLocalBounds() const {
+      return hasBounds;
+   }
+
+   const BoundingBox& getLocalBoundingBox() const {
+      return boundingBox;
+   }
+
+   const BoundingSphere& getLocalBoundingSphere() const {
+      return boundingSphere;
+   }
+
+   void setLocalBounds(const BoundingBox& box, const BoundingSphere& sphere) {
+      boundingBox = box;
+      boundingSphere = sphere;
+      hasBounds = true;
+   }
+
    void draw() const;
 
+   /**
+    * Draws the mesh once per instance in the instance buffer (see setInstanceData())
+    */
+   void drawInstanced(unsigned int numInstances) const;
+
+   /**
+    * Uploads per-instance data, streamed every time (the buffer is orphaned and only reallocated when it grows)
+    */
+   void setInstanceData(const InstanceData *instances, unsigned int numInstances);
+
    void setVertices(const float *vertices, unsigned int numVertices,
                     unsigned int dimensionality = kDefaultDimensionality, GLenum usage = kDefaultUsage);
 
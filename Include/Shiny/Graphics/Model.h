@@ -19,10 +19,16 @@ class Model {
 private:
    SPtr<Mesh> mesh;
    SPtr<ShaderProgram> program;
+   SPtr<ShaderProgram> gBufferProgram;
    MaterialVector materials;
 
    void move(Model &&other);
 
+   /**
+    * Binds the mesh, applies materials and commits the program. Returns false if there is nothing to draw.
+    */
+   bool prepareDraw(RenderData& renderData);
+
 public:
    Model() = default;
 
@@ -34,6 +40,11 @@ public:
 
    void draw(RenderData renderData);
 
+   /**
+    * Draws the mesh once per instance, using the per-instance data most recently uploaded to the mesh
+    */
+   void drawInstanced(RenderData renderData, unsigned int numInstances);
+
    const SPtr<Mesh>& getMesh() const {
       return mesh;
    }
@@ -42,10 +53,35 @@ public:
       return program;
    }
 
+   /**
+    * Program used instead of the main one in G-buffer passes (deferred shading). Models without one are shaded forward
+    * after the deferred lighting.
+    */
+   const SPtr<ShaderProgram>& getGBufferShaderProgram() const {
+      return gBufferProgram;
+   }
+
+   /**
+    * Program that draws with the given render data use (the override, G-buffer or main program)
+    */
+   ShaderProgram* selectShaderProgram(const RenderData& renderData) const {
+      if (ShaderProgram* overrideProgram = renderData.getOverrideProgram()) {
+         return overrideProgram;
+      }
+
+      return renderData.isGBufferPass() ? gBufferProgram.get() : program.get();
+   }
+
+   const MaterialVector& getMaterials() const {
+      return materials;
+   }
+
    void setMesh(const SPtr<Mesh> &mesh);
 
    void setShaderProgram(const SPtr<ShaderProgram> &program);
 
+   void setGBufferShaderProgram(const SPtr<ShaderProgram> &program);
+
    void attachMaterial(const SPtr<Material> &material);
 
    void removeMaterial(const SPtr<Material> &material);
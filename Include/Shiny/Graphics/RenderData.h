@@ -11,7 +11,7 @@ class ShaderProgram;
 class RenderData {
 public:
    RenderData()
-      : nextTextureUnit(0), overrideProgram(nullptr) {
+      : nextTextureUnit(0), overrideProgram(nullptr), gBufferPass(false) {
    }
 
    GLint aquireTextureUnit() {
@@ -27,11 +27,23 @@ public:
       overrideProgram = newOverrideProgram;
    }
 
+   /**
+    * Whether models are being drawn into a G-buffer (with their G-buffer programs) for deferred shading
+    */
+   bool isGBufferPass() const {
+      return gBufferPass;
+   }
+
+   void setGBufferPass(bool newGBufferPass) {
+      gBufferPass = newGBufferPass;
+   }
+
 private:
    static GLint maxTextureUnits();
 
    GLint nextTextureUnit;
    ShaderProgram* overrideProgram;
+   bool gBufferPass;
 };
 
 } // namespace Shiny
@@ -4,36 +4,86 @@
 #include "Shiny/Pointers.h"
 #include "Shiny/Graphics/OpenGL.h"
 #include "Shiny/Graphics/Uniform.h"
+#include "Shiny/Graphics/UniformTypes.h"
 
 #include <array>
+#include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace Shiny {
 
 namespace ShaderAttributes {
 
+// Per-instance matrices occupy one location per column
 enum Attributes : GLint {
    kPosition = 0,
    kNormal = 1,
-   kTexCoord = 2
+   kTexCoord = 2,
+   kInstanceModelMatrix = 3,
+   kInstanceNormalMatrix = 7
 };
 
 namespace {
 
-const std::array<const char*, 3> kNames = {{
-   "aPosition",
-   "aNormal",
-   "aTexCoord"
+const std::array<std::pair<Attributes, const char*>, 5> kNames = {{
+   { kPosition, "aPosition" },
+   { kNormal, "aNormal" },
+   { kTexCoord, "aTexCoord" },
+   { kInstanceModelMatrix, "aInstanceModelMatrix" },
+   { kInstanceNormalMatrix, "aInstanceNormalMatrix" }
 }};
 
 } // namespace
 
 } // namespace ShaderAttributes
 
+namespace ShaderUniforms {
+
+const char* const kModelMatrix = "uModelMatrix";
+const char* const kNormalMatrix = "uNormalMatrix";
+
+} // namespace ShaderUniforms
+
 class Shader;
-using UniformMap = std::unordered_map<std::string, UPtr<Uniform>>;
+class ShaderProgram;
+
+/**
+ * Typed reference to a uniform of a shader program, resolved once by name (and type checked) with
+ * ShaderProgram::getUniform(). Setting a value through a handle is an indexed, non-virtual store. Handles stay valid
+ * when the program is relinked (e.g. when shaders are reloaded) - if the uniform disappears or changes type, setting it
+ * does nothing. Handles refer to the program object they were resolved on, so after the program is moved from, its
+ * handles do nothing (resolve them again on the new program).
+ */
+template<typename T>
+class UniformHandle {
+public:
+   UniformHandle()
+      : program(nullptr), index(0) {
+   }
+
+   bool isValid() const;
+
+   explicit operator bool() const {
+      return isValid();
+   }
+
+   void set(const T& value) const;
+
+private:
+   friend class ShaderProgram;
+
+   using UniformType = typename UniformTraits<T>::Type;
+
+   UniformHandle(ShaderProgram* owningProgram, std::uint32_t slotIndex)
+      : program(owningProgram), index(slotIndex) {
+   }
+
+   ShaderProgram* program;
+   std::uint32_t index;
+};
 
 class ShaderProgram {
 public:
@@ -56,31 +106,121 @@ public:
 
    void commit();
 
+   /**
+    * Whether the program reads its model (and normal) matrices from per-instance attributes, allowing draws of the same
+    * mesh to be batched into a single instanced draw call
+    */
+   bool supportsInstancing() const {
+      return instanced;
+   }
+
+   /**
+    * Whether the program reads its model (and normal) matrices from the ShinyDraw uniform block (see DrawUniformData)
+    */
+   bool usesDrawUniformBlock() const {
+      return drawBlock;
+   }
+
    bool hasUniform(const std::string &name) const {
-      return uniforms.count(name) > 0;
+      return uniformIndices.count(name) > 0;
    }
 
    template<typename T>
    void setUniformValue(const std::string &name, const T &value) {
-      auto itr = uniforms.find(name);
+      auto itr = uniformIndices.find(name);
 
-      if (itr != uniforms.end()) {
-         itr->second->setValue(value);
+      if (itr != uniformIndices.end()) {
+         uniforms[itr->second]->setValue(value);
       } else {
          ASSERT(false, "Uniform with given name doesn't exist: %s", name.c_str());
       }
    }
 
+   /**
+    * Handles to the uniforms set for every model draw, resolved when the program is linked
+    */
+   const UniformHandle<glm::mat4>& getModelMatrixUniform() const {
+      return modelMatrixUniform;
+   }
+
+   const UniformHandle<glm::mat4>& getNormalMatrixUniform() const {
+      return normalMatrixUniform;
+   }
+
+   /**
+    * Resolves a handle to the uniform with the given name. Returns an invalid handle if the program has no such uniform,
+    * or if its type doesn't match T.
+    */
+   template<typename T>
+   UniformHandle<T> getUniform(const std::string &name) {
+      auto itr = uniformIndices.find(name);
+      if (itr == uniformIndices.end()) {
+         return UniformHandle<T>();
+      }
+
+      if (!dynamic_cast<typename UniformHandle<T>::UniformType*>(uniforms[itr->second].get())) {
+         ASSERT(false, "Uniform handle type doesn't match the uniform's type: %s", name.c_str());
+         return UniformHandle<T>();
+      }
+
+      return UniformHandle<T>(this, itr->second);
+   }
+
 private:
+   template<typename T> friend class UniformHandle;
+
    void release();
 
    void move(ShaderProgram &&other);
 
    GLuint id;
    std::vector<SPtr<Shader>> shaders;
-   UniformMap uniforms;
+
+   // Uniforms are stored in slots that keep their index (and type) across relinks, so that handles stay valid. Slots of
+   // uniforms that no longer exist are null.
+   std::vector<UPtr<Uniform>> uniforms;
+   std::vector<GLenum> uniformSlotTypes;
+   std::unordered_map<std::string, std::uint32_t> uniformIndices;
+
+   // Slots of uniforms changed since the last commit
+   std::vector<std::uint32_t> dirtyUniforms;
+
+   UniformHandle<glm::mat4> modelMatrixUniform;
+   UniformHandle<glm::mat4> normalMatrixUniform;
+
+   bool instanced;
+   bool drawBlock;
+};
+
+// Converts values to the type stored by the uniform (booleans are stored as integers)
+template<typename DataType, typename T>
+struct UniformConversion {
+   static DataType convert(const T& value) {
+      return DataType(value);
+   }
 };
 
+template<typename DataType>
+struct UniformConversion<DataType, DataType> {
+   static const DataType& convert(const DataType& value) {
+      return value;
+   }
+};
+
+template<typename T>
+inline bool UniformHandle<T>::isValid() const {
+   // Moved-from programs have no slots left
+   return program && index < program->uniforms.size() && program->uniforms[index];
+}
+
+template<typename T>
+inline void UniformHandle<T>::set(const T& value) const {
+   if (isValid()) {
+      Uniform* uniform = program->uniforms[index].get();
+      static_cast<UniformType*>(uniform)->setTypedValue(UniformConversion<typename UniformType::DataType, T>::convert(value));
+   }
+}
+
 } // namespace Shiny
 
 #endif
@@ -6,14 +6,18 @@
 
 #include <glm/glm.hpp>
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace Shiny {
 
+class ShaderProgram;
+
 class Uniform {
 public:
    Uniform(const std::string& uniformName, const GLint uniformLocation, const GLenum uniformType, const GLuint program)
-      : name(uniformName), location(uniformLocation), type(uniformType), dirty(false) {
+      : name(uniformName), location(uniformLocation), type(uniformType), dirty(false), dirtyList(nullptr), slot(0) {
       ASSERT(program != 0);
    }
 
@@ -37,20 +41,38 @@ public:
       return type;
    }
 
-   void commit() {
+   /**
+    * Uploads the value if it changed since the last commit, returning whether it did
+    */
+   bool commit() {
       if (dirty) {
          commitData();
          dirty = false;
+         return true;
       }
+
+      return false;
    }
 
    template<typename T>
    void setValue(const T& value) {
-      bool valueChanged = setData(value);
-      dirty = dirty || valueChanged;
+      if (setData(value)) {
+         markDirty();
+      }
    }
 
 protected:
+   void markDirty() {
+      // Only the first change since the last commit adds the uniform to the list
+      if (!dirty) {
+         dirty = true;
+
+         if (dirtyList) {
+            dirtyList->push_back(slot);
+         }
+      }
+   }
+
    virtual void commitData() = 0;
 
 #define DECLARE_SET_DATA(type) virtual bool setData(type value) { return typeError(#type); }
@@ -103,6 +125,16 @@ protected:
    virtual const char* getTypeName() const = 0;
 
 private:
+   friend class ShaderProgram;
+
+   /**
+    * Makes the uniform add its slot index to the list whenever it becomes dirty
+    */
+   void setDirtyList(std::vector<std::uint32_t>* newDirtyList, std::uint32_t newSlot) {
+      dirtyList = newDirtyList;
+      slot = newSlot;
+   }
+
    bool typeError(const char* typeName) {
       ASSERT(false, "Trying to set uniform with invalid type (%s, should be %s): %s", typeName, getTypeName(), name.c_str());
       return false;
@@ -112,6 +144,8 @@ private:
    const GLint location;
    const GLenum type;
    bool dirty;
+   std::vector<std::uint32_t>* dirtyList;
+   std::uint32_t slot;
 };
 
 } // namespace Shiny
@@ -33,6 +33,15 @@ public:\
       checkTypeEnum(uniformType, __VA_ARGS__);\
       get_function;\
    }\
+\
+   using DataType = data_type;\
+\
+   /* Non-virtual set, used by uniform handles (which check the type when resolved) */\
+   void setTypedValue(param_type value) {\
+      if (storeData(value)) {\
+         markDirty();\
+      }\
+   }\
 \
 protected:\
    virtual void commitData() override {\
@@ -40,6 +49,10 @@ protected:\
    }\
 \
    virtual bool setData(param_type value) override {\
+      return storeData(value);\
+   }\
+\
+   bool storeData(param_type value) {\
       bool valueChanged = data != value;\
       data = value;\
       return valueChanged;\
@@ -113,6 +126,51 @@ DECLARE_UNIFORM_TYPE_MATRIX(Float4x4Uniform, glm::fmat4x4, glGetUniformfv, glUni
 
 #undef DECLARE_UNIFORM_TYPE
 
+/**
+ * Maps the value type used to set a uniform to the uniform class that stores it
+ */
+template<typename T>
+struct UniformTraits;
+
+#define DECLARE_UNIFORM_TRAITS(value_type, uniform_type)\
+template<>\
+struct UniformTraits<value_type> {\
+   using Type = uniform_type;\
+};
+
+DECLARE_UNIFORM_TRAITS(GLfloat, FloatUniform)
+DECLARE_UNIFORM_TRAITS(GLint, IntUniform)
+DECLARE_UNIFORM_TRAITS(GLuint, UintUniform)
+DECLARE_UNIFORM_TRAITS(bool, BoolUniform)
+
+DECLARE_UNIFORM_TRAITS(glm::fvec2, Float2Uniform)
+DECLARE_UNIFORM_TRAITS(glm::fvec3, Float3Uniform)
+DECLARE_UNIFORM_TRAITS(glm::fvec4, Float4Uniform)
+
+DECLARE_UNIFORM_TRAITS(glm::ivec2, Int2Uniform)
+DECLARE_UNIFORM_TRAITS(glm::ivec3, Int3Uniform)
+DECLARE_UNIFORM_TRAITS(glm::ivec4, Int4Uniform)
+
+DECLARE_UNIFORM_TRAITS(glm::uvec2, Uint2Uniform)
+DECLARE_UNIFORM_TRAITS(glm::uvec3, Uint3Uniform)
+DECLARE_UNIFORM_TRAITS(glm::uvec4, Uint4Uniform)
+
+DECLARE_UNIFORM_TRAITS(glm::bvec2, Bool2Uniform)
+DECLARE_UNIFORM_TRAITS(glm::bvec3, Bool3Uniform)
+DECLARE_UNIFORM_TRAITS(glm::bvec4, Bool4Uniform)
+
+DECLARE_UNIFORM_TRAITS(glm::fmat2x2, Float2x2Uniform)
+DECLARE_UNIFORM_TRAITS(glm::fmat2x3, Float2x3Uniform)
+DECLARE_UNIFORM_TRAITS(glm::fmat2x4, Float2x4Uniform)
+DECLARE_UNIFORM_TRAITS(glm::fmat3x2, Float3x2Uniform)
+DECLARE_UNIFORM_TRAITS(glm::fmat3x3, Float3x3Uniform)
+DECLARE_UNIFORM_TRAITS(glm::fmat3x4, Float3x4Uniform)
+DECLARE_UNIFORM_TRAITS(glm::fmat4x2, Float4x2Uniform)
+DECLARE_UNIFORM_TRAITS(glm::fmat4x3, Float4x3Uniform)
+DECLARE_UNIFORM_TRAITS(glm::fmat4x4, Float4x4Uniform)
+
+#undef DECLARE_UNIFORM_TRAITS
+
 } // namespace Shiny
 
 #endif
@@ -0,0 +1,150 @@
+#ifndef SHINY_BOUNDS_H
+#define SHINY_BOUNDS_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+namespace Shiny {
+
+/**
+ * Axis aligned bounding box. Default constructed boxes are empty (min > max), and grow as points are added.
+ */
+struct BoundingBox {
+   glm::vec3 min;
+   glm::vec3 max;
+
+   BoundingBox()
+      : min(std::numeric_limits<float>::max()), max(-std::numeric_limits<float>::max()) {
+   }
+
+   BoundingBox(const glm::vec3& inMin, const glm::vec3& inMax)
+      : min(inMin), max(inMax) {
+   }
+
+   /**
+    * Bounds of count points, each stride floats apart
+    */
+   static BoundingBox fromPoints(const float* points, std::size_t count, std::size_t stride = 3) {
+      BoundingBox box;
+      for (std::size_t i = 0; i < count; ++i) {
+         const float* point = points + i * stride;
+         box.addPoint(glm::vec3(point[0], point[1], point[2]));
+      }
+
+      return box;
+   }
+
+   bool isEmpty() const {
+      return min.x > max.x || min.y > max.y || min.z > max.z;
+   }
+
+   glm::vec3 getCenter() const {
+      return (min + max) * 0.5f;
+   }
+
+   glm::vec3 getExtent() const {
+      return (max - min) * 0.5f;
+   }
+
+   void addPoint(const glm::vec3& point) {
+      min = glm::vec3(std::min(min.x, point.x), std::min(min.y, point.y), std::min(min.z, point.z));
+      max = glm::vec3(std::max(max.x, point.x), std::max(max.y, point.y), std::max(max.z, point.z));
+   }
+
+   void addBox(const BoundingBox& other) {
+      min = glm::vec3(std::min(min.x, other.min.x), std::min(min.y, other.min.y), std::min(min.z, other.min.z));
+      max = glm::vec3(std::max(max.x, other.max.x), std::max(max.y, other.max.y), std::max(max.z, other.max.z));
+   }
+
+   bool contains(const glm::vec3& point) const {
+      return point.x >= min.x && point.x <= max.x && point.y >= min.y && point.y <= max.y && point.z >= min.z && point.z <= max.z;
+   }
+
+   bool overlaps(const BoundingBox& other) const {
+      return min.x <= other.max.x && max.x >= other.min.x && min.y <= other.max.y && max.y >= other.min.y && min.z <= other.max.z && max.z >= other.min.z;
+   }
+
+   /**
+    * Bounds of this box after being transformed by the given affine matrix (Arvo's method)
+    */
+   BoundingBox transformed(const glm::mat4& matrix) const {
+      if (isEmpty()) {
+         return *this;
+      }
+
+      glm::vec3 center = getCenter();
+      glm::vec3 extent = getExtent();
+
+      glm::vec3 newCenter(matrix[3]);
+      glm::vec3 newExtent(0.0f);
+      for (int column = 0; column < 3; ++column) {
+         for (int row = 0; row < 3; ++row) {
+            newCenter[row] += matrix[column][row] * center[column];
+            newExtent[row] += std::fabs(matrix[column][row]) * extent[column];
+         }
+      }
+
+      return BoundingBox(newCenter - newExtent, newCenter + newExtent);
+   }
+};
+
+struct BoundingSphere {
+   glm::vec3 center;
+   float radius;
+
+   BoundingSphere(const glm::vec3& inCenter = glm::vec3(0.0f), float inRadius = 0.0f)
+      : center(inCenter), radius(inRadius) {
+   }
+
+   /**
+    * Sphere around the center of the given box, just large enough to contain all of the points
+    */
+   static BoundingSphere fromPoints(const BoundingBox& box, const float* points, std::size_t count, std::size_t stride = 3) {
+      if (box.isEmpty()) {
+         return BoundingSphere();
+      }
+
+      glm::vec3 center = box.getCenter();
+      float radiusSquared = 0.0f;
+      for (std::size_t i = 0; i < count; ++i) {
+         const float* point = points + i * stride;
+         glm::vec3 offset = glm::vec3(point[0], point[1], point[2]) - center;
+         radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+      }
+
+      return BoundingSphere(center, std::sqrt(radiusSquared));
+   }
+
+   bool contains(const glm::vec3& point) const {
+      glm::vec3 offset = point - center;
+      return glm::dot(offset, offset) <= radius * radius;
+   }
+
+   bool overlaps(const BoundingSphere& other) const {
+      glm::vec3 offset = other.center - center;
+      float radiusSum = radius + other.radius;
+      return glm::dot(offset, offset) <= radiusSum * radiusSum;
+   }
+
+   /**
+    * Bounds of this sphere after being transformed by the given affine matrix (the radius is scaled by the largest axis
+    * scale, so the result stays conservative under non-uniform scale)
+    */
+   BoundingSphere transformed(const glm::mat4& matrix) const {
+      glm::vec3 newCenter(matrix * glm::vec4(center, 1.0f));
+
+      float maxScaleSquared = std::max(glm::dot(glm::vec3(matrix[0]), glm::vec3(matrix[0])),
+                                       std::max(glm::dot(glm::vec3(matrix[1]), glm::vec3(matrix[1])),
+                                                glm::dot(glm::vec3(matrix[2]), glm::vec3(matrix[2]))));
+
+      return BoundingSphere(newCenter, radius * std::sqrt(maxScaleSquared));
+   }
+};
+
+} // namespace Shiny
+
+#endif
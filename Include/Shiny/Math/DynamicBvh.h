@@ -0,0 +1,331 @@
+#ifndef SHINY_DYNAMIC_BVH_H
+#define SHINY_DYNAMIC_BVH_H
+
+#include "Shiny/ShinyAssert.h"
+#include "Shiny/Math/Bounds.h"
+#include "Shiny/Math/Frustum.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Shiny {
+
+/**
+ * Dynamic bounding volume hierarchy (AABB tree). Each proxy is stored in a leaf with a "fat" box (its box grown by a
+ * margin), so small movements don't touch the tree at all - larger ones remove and re-insert the leaf, which costs
+ * O(log n). Inserts pick the sibling with the lowest surface area cost and the tree is kept balanced with rotations. The
+ * tree is rebuilt from scratch (top-down, median split) once enough proxies have been re-inserted to degrade it.
+ *
+ * Query callbacks receive the id of each proxy whose fat box overlaps the query, and return false to stop the query.
+ */
+class DynamicBvh {
+public:
+   using ProxyId = std::int32_t;
+
+   static const ProxyId kNullProxy = -1;
+
+   DynamicBvh(float inMargin = 0.1f);
+
+   ProxyId createProxy(const BoundingBox& box, void* userData);
+
+   void destroyProxy(ProxyId proxyId);
+
+   /**
+    * Updates the bounds of a proxy. Returns true if the proxy had to be re-inserted (the box left the fat box).
+    */
+   bool moveProxy(ProxyId proxyId, const BoundingBox& box);
+
+   void* getUserData(ProxyId proxyId) const {
+      ASSERT(isValidProxy(proxyId), "Invalid proxy: %d", proxyId);
+      return nodes[proxyId].userData;
+   }
+
+   const BoundingBox& getFatBox(ProxyId proxyId) const {
+      ASSERT(isValidProxy(proxyId), "Invalid proxy: %d", proxyId);
+      return nodes[proxyId].box;
+   }
+
+   std::size_t getNumProxies() const {
+      return numProxies;
+   }
+
+   /**
+    * Height of the tree (0 for a single leaf, -1 when empty)
+    */
+   int getHeight() const {
+      return root == kNullNode ? -1 : nodes[root].height;
+   }
+
+   /**
+    * Rebuilds the whole tree if enough proxies have been re-inserted since the last rebuild. Should be called
+    * periodically (e.g. once per frame, after moving proxies).
+    */
+   void rebuildIfNeeded();
+
+   void rebuild();
+
+   template<typename Callback>
+   void query(const BoundingBox& box, Callback&& callback) const {
+      traverse([&box](const BoundingBox& nodeBox) {
+         return nodeBox.overlaps(box);
+      }, callback);
+   }
+
+   template<typename Callback>
+   void query(const BoundingSphere& sphere, Callback&& callback) const {
+      traverse([&sphere](const BoundingBox& nodeBox) {
+         return distanceSquared(nodeBox, sphere.center) <= sphere.radius * sphere.radius;
+      }, callback);
+   }
+
+   /**
+    * Reports every proxy overlapping the frustum. Subtrees that are entirely inside the frustum are reported without
+    * testing any more planes.
+    */
+   template<typename Callback>
+   void query(const Frustum& frustum, Callback&& callback) const;
+
+   /**
+    * Casts a ray against the fat boxes, in no particular order. The callback receives the proxy id and the distance along
+    * the ray at which the ray enters its box, and returns the new maximum distance (return maxDistance to keep going
+    * unchanged, a smaller value to clip the ray, or a negative value to stop).
+    */
+   template<typename Callback>
+   void raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Callback&& callback) const;
+
+   /**
+    * Finds (up to) the k proxies whose fat boxes are closest to the point, ordered nearest first
+    */
+   void findNearest(const glm::vec3& point, std::size_t k, std::vector<ProxyId>& results) const;
+
+private:
+   using NodeIndex = std::int32_t;
+
+   static const NodeIndex kNullNode = -1;
+
+   // Traversal stacks are local to each query (so that queries are reentrant and thread safe), reserved up front
+   static const std::size_t kInitialStackCapacity = 64;
+
+   struct Node {
+      bool isLeaf() const {
+         return child1 == kNullNode;
+      }
+
+      BoundingBox box;
+      void* userData;
+
+      // Next free node when the node isn't in use
+      NodeIndex parent;
+
+      NodeIndex child1;
+      NodeIndex child2;
+
+      // Leaves have a height of 0, free nodes -1
+      int height;
+   };
+
+   static float distanceSquared(const BoundingBox& box, const glm::vec3& point) {
+      glm::vec3 closest(std::min(std::max(point.x, box.min.x), box.max.x),
+                        std::min(std::max(point.y, box.min.y), box.max.y),
+                        std::min(std::max(point.z, box.min.z), box.max.z));
+      glm::vec3 offset = point - closest;
+      return glm::dot(offset, offset);
+   }
+
+   bool isValidProxy(ProxyId proxyId) const {
+      return proxyId >= 0 && static_cast<std::size_t>(proxyId) < nodes.size() && nodes[proxyId].height == 0;
+   }
+
+   template<typename Overlaps, typename Callback>
+   void traverse(Overlaps&& overlaps, Callback&& callback) const {
+      if (root == kNullNode) {
+         return;
+      }
+
+      std::vector<NodeIndex> stack;
+      stack.reserve(kInitialStackCapacity);
+      stack.push_back(root);
+
+      while (!stack.empty()) {
+         NodeIndex index = stack.back();
+         stack.pop_back();
+
+         const Node& node = nodes[index];
+         if (!overlaps(node.box)) {
+            continue;
+         }
+
+         if (node.isLeaf()) {
+            if (!callback(static_cast<ProxyId>(index))) {
+               return;
+            }
+         } else {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+         }
+      }
+   }
+
+   /**
+    * Reports all leaves below the node. Returns false if the callback stopped the query.
+    */
+   template<typename Callback>
+   bool reportSubtree(NodeIndex index, std::vector<NodeIndex>& stack, Callback&& callback) const {
+      std::size_t base = stack.size();
+      stack.push_back(index);
+
+      while (stack.size() > base) {
+         NodeIndex current = stack.back();
+         stack.pop_back();
+
+         const Node& node = nodes[current];
+         if (node.isLeaf()) {
+            if (!callback(static_cast<ProxyId>(current))) {
+               return false;
+            }
+         } else {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+         }
+      }
+
+      return true;
+   }
+
+   NodeIndex allocateNode();
+   void freeNode(NodeIndex index);
+
+   void insertLeaf(NodeIndex leaf);
+   void removeLeaf(NodeIndex leaf);
+   void refitAncestors(NodeIndex index);
+   NodeIndex balance(NodeIndex index);
+   NodeIndex buildTopDown(NodeIndex* leaves, std::size_t count);
+
+   std::vector<Node> nodes;
+   NodeIndex root;
+   NodeIndex freeList;
+   std::size_t numProxies;
+   std::size_t numReinsertsSinceRebuild;
+   float margin;
+};
+
+template<typename Callback>
+void DynamicBvh::query(const Frustum& frustum, Callback&& callback) const {
+   if (root == kNullNode) {
+      return;
+   }
+
+   const std::uint32_t kAllPlanes = (1u << Frustum::kNumPlanes) - 1;
+
+   // Node indices, along with the mask of planes each node still needs to be tested against
+   std::vector<NodeIndex> stack;
+   std::vector<std::uint32_t> masks;
+   stack.reserve(kInitialStackCapacity);
+   masks.reserve(kInitialStackCapacity);
+   stack.push_back(root);
+   masks.push_back(kAllPlanes);
+
+   std::vector<NodeIndex> subtreeStack;
+   while (!stack.empty()) {
+      NodeIndex index = stack.back();
+      std::uint32_t mask = masks.back();
+      stack.pop_back();
+      masks.pop_back();
+
+      const Node& node = nodes[index];
+      bool outside = false;
+      for (int i = 0; i < Frustum::kNumPlanes && !outside; ++i) {
+         if (!(mask & (1u << i))) {
+            continue;
+         }
+
+         const glm::vec4& plane = frustum.getPlane(static_cast<Frustum::Plane>(i));
+         glm::vec3 positiveCorner(plane.x >= 0.0f ? node.box.max.x : node.box.min.x,
+                                  plane.y >= 0.0f ? node.box.max.y : node.box.min.y,
+                                  plane.z >= 0.0f ? node.box.max.z : node.box.min.z);
+         glm::vec3 negativeCorner(plane.x >= 0.0f ? node.box.min.x : node.box.max.x,
+                                  plane.y >= 0.0f ? node.box.min.y : node.box.max.y,
+                                  plane.z >= 0.0f ? node.box.min.z : node.box.max.z);
+
+         if (glm::dot(glm::vec3(plane), positiveCorner) + plane.w < 0.0f) {
+            outside = true;
+         } else if (glm::dot(glm::vec3(plane), negativeCorner) + plane.w >= 0.0f) {
+            // Entirely in front of this plane, so no descendant needs to test it again
+            mask &= ~(1u << i);
+         }
+      }
+
+      if (outside) {
+         continue;
+      }
+
+      if (mask == 0 || node.isLeaf()) {
+         if (!reportSubtree(index, subtreeStack, callback)) {
+            return;
+         }
+      } else {
+         stack.push_back(node.child1);
+         masks.push_back(mask);
+         stack.push_back(node.child2);
+         masks.push_back(mask);
+      }
+   }
+}
+
+template<typename Callback>
+void DynamicBvh::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Callback&& callback) const {
+   glm::vec3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+   auto enterDistance = [&origin, &inverseDirection](const BoundingBox& box, float currentMaxDistance, float& distance) {
+      float tMin = 0.0f;
+      float tMax = currentMaxDistance;
+      for (int axis = 0; axis < 3; ++axis) {
+         float t1 = (box.min[axis] - origin[axis]) * inverseDirection[axis];
+         float t2 = (box.max[axis] - origin[axis]) * inverseDirection[axis];
+
+         // NaN (ray parallel to and on the slab's boundary) is treated as inside
+         tMin = std::max(tMin, std::min(t1, t2));
+         tMax = std::min(tMax, std::max(t1, t2));
+      }
+
+      distance = tMin;
+      return tMin <= tMax;
+   };
+
+   if (root == kNullNode) {
+      return;
+   }
+
+   std::vector<NodeIndex> stack;
+   stack.reserve(kInitialStackCapacity);
+   stack.push_back(root);
+
+   while (!stack.empty()) {
+      NodeIndex index = stack.back();
+      stack.pop_back();
+
+      const Node& node = nodes[index];
+      float distance = 0.0f;
+      if (!enterDistance(node.box, maxDistance, distance)) {
+         continue;
+      }
+
+      if (node.isLeaf()) {
+         maxDistance = callback(static_cast<ProxyId>(index), distance);
+         if (maxDistance < 0.0f) {
+            return;
+         }
+      } else {
+         stack.push_back(node.child1);
+         stack.push_back(node.child2);
+      }
+   }
+}
+
+} // namespace Shiny
+
+#endif
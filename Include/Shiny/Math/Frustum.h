@@ -0,0 +1,61 @@
+#ifndef SHINY_FRUSTUM_H
+#define SHINY_FRUSTUM_H
+
+#include "Shiny/Math/Bounds.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Shiny {
+
+/**
+ * View frustum, stored as six normalized planes facing inward (a point p is inside a plane if dot(plane.xyz, p) +
+ * plane.w >= 0)
+ */
+class Frustum {
+public:
+   enum Plane {
+      kLeft,
+      kRight,
+      kBottom,
+      kTop,
+      kNear,
+      kFar,
+      kNumPlanes
+   };
+
+   /**
+    * Creates a frustum that contains everything
+    */
+   Frustum();
+
+   /**
+    * Extracts the planes of an OpenGL style (-1 to 1 clip space depth) view-projection matrix
+    */
+   static Frustum fromMatrix(const glm::mat4& viewProjection);
+
+   const glm::vec4& getPlane(Plane plane) const {
+      return planes[plane];
+   }
+
+   bool intersects(const BoundingSphere& sphere) const;
+
+   bool intersects(const BoundingBox& box) const;
+
+   /**
+    * Tests count spheres at once (several per iteration when SIMD is available), writing the indices of the spheres
+    * that intersect the frustum to visibleIndices (which must have room for count indices). Returns the number of
+    * visible spheres.
+    */
+   std::size_t cullSpheres(const BoundingSphere* spheres, std::size_t count, std::uint32_t* visibleIndices) const;
+
+private:
+   std::array<glm::vec4, kNumPlanes> planes;
+};
+
+} // namespace Shiny
+
+#endif
@@ -31,6 +31,20 @@ struct Transform {
       return glm::translate(position) * glm::toMat4(orientation) * glm::scale(scale);
    }
 
+   /**
+    * Inverse transpose of the upper 3x3 of toMatrix(), built directly from the rotation and scale (R * S^-1)
+    */
+   glm::mat4 toNormalMatrix() const {
+      glm::vec3 inverseScale = MathUtils::safeReciprocal(scale);
+
+      glm::mat4 normalMatrix = glm::toMat4(orientation);
+      normalMatrix[0] *= inverseScale.x;
+      normalMatrix[1] *= inverseScale.y;
+      normalMatrix[2] *= inverseScale.z;
+
+      return normalMatrix;
+   }
+
    Transform operator*(const Transform& other) const {
       Transform result;
       multiply(result, *this, other);
@@ -0,0 +1,45 @@
+#ifndef SHINY_TRANSFORM_BATCH_H
+#define SHINY_TRANSFORM_BATCH_H
+
+#include "Shiny/Math/Transform.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+namespace Shiny {
+
+/**
+ * Batch versions of the Transform operations. Transforms are transposed into structure-of-arrays blocks and processed
+ * several at a time with AVX (when building with SHINY_ENABLE_AVX2) or SSE, falling back to scalar code on other
+ * architectures. Results match the single transform versions, up to floating point rounding.
+ *
+ * Results may alias inputs of the same type.
+ */
+namespace TransformBatch {
+
+/**
+ * results[i] = first[i] * second[i]
+ */
+void multiply(Transform* results, const Transform* first, const Transform* second, std::size_t count);
+
+/**
+ * results[i] = transforms[i].inverse()
+ */
+void inverse(Transform* results, const Transform* transforms, std::size_t count);
+
+/**
+ * results[i] = transforms[i].toMatrix()
+ */
+void toMatrix(glm::mat4* results, const Transform* transforms, std::size_t count);
+
+/**
+ * results[i] = transforms[i].toNormalMatrix()
+ */
+void toNormalMatrix(glm::mat4* results, const Transform* transforms, std::size_t count);
+
+} // namespace TransformBatch
+
+} // namespace Shiny
+
+#endif
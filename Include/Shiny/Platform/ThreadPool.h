@@ -0,0 +1,61 @@
+#ifndef SHINY_THREAD_POOL_H
+#define SHINY_THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Shiny {
+
+/**
+ * Fixed set of worker threads that execute queued tasks in FIFO order
+ */
+class ThreadPool {
+public:
+   using Task = std::function<void()>;
+   using RangeFunc = std::function<void(std::size_t begin, std::size_t end)>;
+
+   /**
+    * One less than the number of hardware threads (leaving room for the main thread), but at least one
+    */
+   static std::size_t getDefaultNumThreads();
+
+   ThreadPool(std::size_t numThreads = getDefaultNumThreads());
+   ThreadPool(const ThreadPool& other) = delete;
+   ThreadPool(ThreadPool&& other) = delete;
+
+   ~ThreadPool();
+
+   ThreadPool& operator=(const ThreadPool& other) = delete;
+   ThreadPool& operator=(ThreadPool&& other) = delete;
+
+   std::size_t getNumThreads() const {
+      return threads.size();
+   }
+
+   void enqueue(Task task);
+
+   /**
+    * Splits [0, count) into chunks of at least minChunkSize elements and calls the function on each chunk, spread
+    * across the workers and the calling thread. Blocks until all chunks are processed. Safe to call from a task running
+    * on the pool (the calling thread processes chunks itself instead of waiting idle).
+    */
+   void parallelFor(std::size_t count, std::size_t minChunkSize, const RangeFunc& function);
+
+private:
+   void workerLoop();
+
+   std::vector<std::thread> threads;
+   std::deque<Task> tasks;
+   std::mutex mutex;
+   std::condition_variable condition;
+   bool stopping;
+};
+
+} // namespace Shiny
+
+#endif
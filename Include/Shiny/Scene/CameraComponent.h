@@ -1,16 +1,25 @@
 #ifndef SHINY_CAMERA_COMPONENT_H
 #define SHINY_CAMERA_COMPONENT_H
 
+#include "Shiny/Math/Frustum.h"
 #include "Shiny/Scene/TransformComponent.h"
 
 namespace Shiny {
 
 class CameraComponent : public TransformComponent {
 public:
+   SHINY_DECLARE_COMPONENT(CameraComponent, TransformComponent)
+
    glm::vec3 getFront() const;
    glm::vec3 getRight() const;
    glm::vec3 getUp() const;
    glm::mat4 getViewMatrix() const;
+   glm::mat4 getProjectionMatrix() const;
+
+   /**
+    * World space view frustum, built from the view and projection matrices
+    */
+   Frustum getFrustum() const;
 
    float getFov() const {
       return fov;
@@ -20,6 +29,36 @@ public:
       fov = newFov;
    }
 
+   float getNearPlane() const {
+      return nearPlane;
+   }
+
+   void setNearPlane(float newNearPlane) {
+      nearPlane = newNearPlane;
+   }
+
+   float getFarPlane() const {
+      return farPlane;
+   }
+
+   void setFarPlane(float newFarPlane) {
+      farPlane = newFarPlane;
+   }
+
+   /**
+    * Width / height - the override if one is set, otherwise that of the current context's viewport (so that the
+    * projection follows framebuffer size changes)
+    */
+   float getAspectRatio() const;
+
+   /**
+    * Overrides the aspect ratio (e.g. when rendering to a target that isn't the size of the window). Set to 0 to follow
+    * the viewport again.
+    */
+   void setAspectRatio(float newAspectRatio) {
+      aspectRatio = newAspectRatio;
+   }
+
    void fly(float amount);
    void strafe(float amount);
    void rotate(float pitch, float yaw);
@@ -29,11 +68,14 @@ protected:
    friend class ComponentRegistrar<CameraComponent>;
 
    CameraComponent(Entity& entity)
-      : TransformComponent(entity), fov(70.0f) {
+      : TransformComponent(entity), fov(70.0f), nearPlane(0.1f), farPlane(1000.0f), aspectRatio(0.0f) {
    }
 
 private:
    float fov;
+   float nearPlane;
+   float farPlane;
+   float aspectRatio;
 };
 
 SHINY_REFERENCE_COMPONENT(CameraComponent)
@@ -7,8 +7,12 @@ namespace Shiny {
 
 class DirectionalLightComponent : public LightComponent {
 public:
+   SHINY_DECLARE_COMPONENT(DirectionalLightComponent, LightComponent)
+
    virtual void apply(ShaderProgram& program, RenderData& renderData) override;
 
+   virtual void writeFrameData(FrameUniformData::Light& light) const override;
+
 protected:
    friend class ComponentRegistrar<DirectionalLightComponent>;
 
@@ -0,0 +1,148 @@
+#ifndef SHINY_LIGHT_CLUSTERS_H
+#define SHINY_LIGHT_CLUSTERS_H
+
+#include "Shiny/Graphics/FrameUniforms.h"
+#include "Shiny/Graphics/Material.h"
+#include "Shiny/Graphics/OpenGL.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Shiny {
+
+class CameraComponent;
+class LightComponent;
+class Scene;
+
+/**
+ * Clustered (froxel) light assignment. The camera's view frustum is split into screen-space tiles and exponentially
+ * spaced depth slices. Each light with a limited range (point and spot lights) is assigned to every cluster it may
+ * touch. The results are uploaded to three buffer textures, and apply() binds them:
+ *
+ * uniform samplerBuffer uClusterLights;         // 4 texels per light, laid out like ShinyLight (see FrameUniforms.h)
+ * uniform usamplerBuffer uClusterGrid;          // per cluster: r = offset into uClusterLightIndices, g = light count
+ * uniform usamplerBuffer uClusterLightIndices;  // light indices, grouped by cluster
+ * uniform ivec3 uClusterDims;                   // tiles x, tiles y, slices
+ * uniform vec2 uClusterDepthParams;             // slice = int(log(viewDepth) * x + y)
+ * uniform vec2 uClusterTileScale;               // tile = ivec2(gl_FragCoord.xy * uClusterTileScale)
+ *
+ * int cluster = (slice * uClusterDims.y + tile.y) * uClusterDims.x + tile.x;
+ *
+ * Lights that affect everything (e.g. directional lights) aren't clustered - they are in the ShinyFrame block.
+ * Add the clusters to the models' materials to give their programs access to the lights.
+ */
+class LightClusters : public Material {
+public:
+   static const int kTilesX = 16;
+   static const int kTilesY = 9;
+   static const int kSlices = 24;
+   static const int kTilesPerSlice = kTilesX * kTilesY;
+   static const int kNumClusters = kTilesPerSlice * kSlices;
+
+   static const std::size_t kMaxLights = 1024;
+
+   static int getClusterIndex(int tileX, int tileY, int slice) {
+      return (slice * kTilesY + tileY) * kTilesX + tileX;
+   }
+
+   LightClusters();
+   LightClusters(const LightClusters& other) = delete;
+   LightClusters(LightClusters&& other) = delete;
+
+   virtual ~LightClusters();
+
+   LightClusters& operator=(const LightClusters& other) = delete;
+   LightClusters& operator=(LightClusters&& other) = delete;
+
+   /**
+    * Assigns the lights to the clusters of the camera's view and uploads the results. Call once per frame, after
+    * Scene::updateTransforms().
+    */
+   void update(const Scene& scene, const CameraComponent& camera) {
+      assign(scene, camera);
+      upload();
+   }
+
+   /**
+    * CPU part of update() - assigns the lights visible to the camera (found through the scene's light spatial index) to
+    * clusters
+    */
+   void assign(const Scene& scene, const CameraComponent& camera);
+
+   /**
+    * GPU part of update() - uploads the light data, cluster grid and light index lists
+    */
+   void upload();
+
+   virtual void apply(ShaderProgram& program, RenderData& renderData) override;
+
+   std::size_t getNumLights() const {
+      return lights.size();
+   }
+
+   LightComponent* getLight(std::size_t index) const {
+      return lights[index];
+   }
+
+   std::uint32_t getClusterLightCount(int clusterIndex) const {
+      return clusterGrid[clusterIndex].y;
+   }
+
+   /**
+    * Index (into the assigned lights) of the ith light in the cluster
+    */
+   std::uint32_t getClusterLight(int clusterIndex, std::uint32_t i) const {
+      return lightIndices[clusterGrid[clusterIndex].x + i];
+   }
+
+private:
+   struct BufferTexture {
+      GLuint buffer = 0;
+      GLuint texture = 0;
+   };
+
+   void updateClusterBounds(const CameraComponent& camera);
+   void assignLight(std::uint32_t lightIndex, const glm::mat4& viewMatrix);
+
+   void uploadBufferTexture(BufferTexture& bufferTexture, GLenum internalFormat, const void* data, std::size_t size);
+   void bindBufferTexture(ShaderProgram& program, RenderData& renderData, const char* uniformName, const BufferTexture& bufferTexture) const;
+
+   // Camera parameters the cluster bounds were computed for
+   float boundsFov;
+   float boundsAspectRatio;
+   float boundsNearPlane;
+   float boundsFarPlane;
+
+   // View-space bounds of the tiles of each slice (x / y), stored per component so that four tiles are tested at once.
+   // Depths are positive distances in front of the camera.
+   alignas(16) std::array<float, kNumClusters> clusterMinX;
+   alignas(16) std::array<float, kNumClusters> clusterMaxX;
+   alignas(16) std::array<float, kNumClusters> clusterMinY;
+   alignas(16) std::array<float, kNumClusters> clusterMaxY;
+   std::array<float, kSlices + 1> sliceDepths;
+
+   float depthScale;
+   float depthBias;
+
+   std::vector<LightComponent*> lights;
+   std::vector<FrameUniformData::Light> lightData;
+   std::vector<glm::uvec2> clusterGrid;
+   std::vector<std::uint32_t> lightIndices;
+
+   // (cluster, light) pairs found while assigning lights, sorted into the grid afterwards
+   std::vector<std::uint32_t> pairClusters;
+   std::vector<std::uint32_t> pairLights;
+   std::vector<std::uint32_t> overlappingTiles;
+
+   BufferTexture lightTexture;
+   BufferTexture gridTexture;
+   BufferTexture indexTexture;
+};
+
+} // namespace Shiny
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef SHINY_LIGHT_COMPONENT_H
 #define SHINY_LIGHT_COMPONENT_H
 
+#include "Shiny/Graphics/FrameUniforms.h"
+#include "Shiny/Math/Bounds.h"
 #include "Shiny/Scene/TransformComponent.h"
 
 #include <glm/glm.hpp>
@@ -12,8 +14,21 @@ class RenderData;
 
 class LightComponent : public TransformComponent {
 public:
+   SHINY_DECLARE_COMPONENT(LightComponent, TransformComponent)
+
    virtual void apply(ShaderProgram& program, RenderData& renderData);
 
+   /**
+    * Writes the light's parameters into its slot of the per-frame uniform block
+    */
+   virtual void writeFrameData(FrameUniformData::Light& light) const;
+
+   /**
+    * Sphere containing everything the light affects. Lights that affect everything (e.g. directional lights) have an
+    * infinite radius.
+    */
+   virtual BoundingSphere getWorldBoundingSphere() const;
+
    const glm::vec3& getColor() const {
       return color;
    }
@@ -27,6 +42,11 @@ protected:
 
    LightComponent(Entity& entity);
 
+   /**
+    * Distance at which a light with the given square falloff fades below a perceptible intensity
+    */
+   static float getFalloffRadius(float squareFalloff);
+
 private:
    glm::vec3 color;
 };
@@ -1,28 +1,47 @@
 #ifndef SHINY_MODEL_COMPONENT_H
 #define SHINY_MODEL_COMPONENT_H
 
+#include "Shiny/Graphics/Mesh.h"
 #include "Shiny/Graphics/Model.h"
+#include "Shiny/Math/Bounds.h"
+#include "Shiny/Math/DynamicBvh.h"
 #include "Shiny/Scene/TransformComponent.h"
 
 namespace Shiny {
 
 class ModelComponent : public TransformComponent {
 public:
+   SHINY_DECLARE_COMPONENT(ModelComponent, TransformComponent)
+
    using OnShaderProgramChangeDelegate = Delegate<void, ModelComponent*, ShaderProgram*>;
 
    void render(RenderData renderData);
 
-   OnShaderProgramChangeDelegate::Handle bindOnShaderProgramChange(const OnShaderProgramChangeDelegate::FuncType& function) {
-      return onShaderProgramChange.bind(function);
+   /**
+    * Renders this model's mesh, program and materials once per instance with a single draw call. The program (or the
+    * override program) must support instancing.
+    */
+   void renderInstanced(RenderData renderData, const Mesh::InstanceData* instances, unsigned int numInstances);
+
+   /**
+    * Whether this model can be drawn in the same instanced draw call as the other model (same mesh, and, unless
+    * overridden, same programs and materials)
+    */
+   bool canInstanceWith(const ModelComponent& other, bool programOverridden) const;
+
+   template<typename Function>
+   OnShaderProgramChangeDelegate::Handle bindOnShaderProgramChange(Function&& function) {
+      return onShaderProgramChange.bind(std::forward<Function>(function));
    }
 
    const SPtr<Mesh>& getMesh() const {
       return model.getMesh();
    }
 
-   void setMesh(const SPtr<Mesh>& mesh) {
-      model.setMesh(mesh);
-   }
+   /**
+    * Also re-evaluates whether the model has bounds (set the mesh again after giving it its first vertices)
+    */
+   void setMesh(const SPtr<Mesh>& mesh);
 
    const SPtr<ShaderProgram>& getShaderProgram() const {
       return model.getShaderProgram();
@@ -33,6 +52,21 @@ public:
       model.setShaderProgram(program);
    }
 
+   const SPtr<ShaderProgram>& getGBufferShaderProgram() const {
+      return model.getGBufferShaderProgram();
+   }
+
+   /**
+    * Program that writes the G-buffer when the model is rendered with the deferred path
+    */
+   void setGBufferShaderProgram(const SPtr<ShaderProgram>& program) {
+      model.setGBufferShaderProgram(program);
+   }
+
+   ShaderProgram* selectShaderProgram(const RenderData& renderData) const {
+      return model.selectShaderProgram(renderData);
+   }
+
    void attachMaterial(const SPtr<Material>& material) {
       model.attachMaterial(material);
    }
@@ -41,14 +75,54 @@ public:
       model.removeMaterial(material);
    }
 
+   /**
+    * Whether the mesh has bounds - models without bounds should never be culled
+    */
+   bool hasBounds() const;
+
+   /**
+    * Mesh bounds in world space, derived from the cached world matrix
+    */
+   BoundingBox getWorldBoundingBox() const;
+   BoundingSphere getWorldBoundingSphere() const;
+
+   const MaterialVector& getMaterials() const {
+      return model.getMaterials();
+   }
+
+   /**
+    * Translucent models are drawn after opaque ones in the same pass, back to front
+    */
+   bool isTranslucent() const {
+      return translucent;
+   }
+
+   void setTranslucent(bool newTranslucent) {
+      translucent = newTranslucent;
+   }
+
 protected:
    friend class ComponentRegistrar<ModelComponent>;
 
    ModelComponent(Entity& entity);
 
+   void onWorldTransformInvalidated() override;
+
 private:
+   friend class Scene;
+
+   static const std::size_t kNotUnbounded = static_cast<std::size_t>(-1);
+
    Model model;
    OnShaderProgramChangeDelegate onShaderProgramChange;
+   bool translucent;
+
+   // Spatial index bookkeeping, owned by the scene (untracked once the component is being destroyed, since orphaning
+   // its children can still move it)
+   DynamicBvh::ProxyId spatialProxyId;
+   std::size_t unboundedIndex;
+   bool spatialUpdatePending;
+   bool spatiallyTracked;
 };
 
 SHINY_REFERENCE_COMPONENT(ModelComponent)
@@ -7,8 +7,14 @@ namespace Shiny {
 
 class PointLightComponent : public LightComponent {
 public:
+   SHINY_DECLARE_COMPONENT(PointLightComponent, LightComponent)
+
    virtual void apply(ShaderProgram& program, RenderData& renderData) override;
 
+   virtual void writeFrameData(FrameUniformData::Light& light) const override;
+
+   virtual BoundingSphere getWorldBoundingSphere() const override;
+
    float getSquareFalloff() const {
       return squareFalloff;
    }
@@ -0,0 +1,126 @@
+#ifndef SHINY_RENDER_COMMAND_LIST_H
+#define SHINY_RENDER_COMMAND_LIST_H
+
+#include "Shiny/Graphics/FrameUniforms.h"
+#include "Shiny/Graphics/Mesh.h"
+#include "Shiny/Graphics/OpenGL.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Shiny {
+
+class ModelComponent;
+class RenderData;
+class ShaderProgram;
+
+/**
+ * Compact list of draw commands. Recording makes no GL calls (per-draw matrices and instance data are copied into the
+ * list), so lists for disjoint parts of a frame can be recorded on worker threads. replay() then issues the GL calls,
+ * on the thread that owns the context.
+ */
+class RenderCommandList {
+public:
+   enum class CommandType : std::uint8_t {
+      // object = ShaderProgram, used by the following commands
+      kBindProgram,
+
+      // object = ModelComponent, whose materials are applied to the bound program
+      kApplyMaterials,
+
+      // object = Mesh, index = per-draw data slot
+      kDraw,
+
+      // object = Mesh, index = first instance, count = number of instances
+      kDrawInstanced
+   };
+
+   struct Command {
+      void* object;
+      std::uint32_t index;
+      std::uint32_t count;
+      CommandType type;
+   };
+
+   /**
+    * Distance between per-draw data slots, so that each slot can be bound as a uniform buffer range. Must be called on
+    * the thread that owns the context.
+    */
+   static std::size_t getDrawDataStride();
+
+   RenderCommandList();
+   RenderCommandList(const RenderCommandList& other) = delete;
+   RenderCommandList(RenderCommandList&& other) = delete;
+
+   ~RenderCommandList();
+
+   RenderCommandList& operator=(const RenderCommandList& other) = delete;
+   RenderCommandList& operator=(RenderCommandList&& other) = delete;
+
+   /**
+    * Removes all commands, keeping the allocated memory. The stride comes from getDrawDataStride().
+    */
+   void reset(std::size_t newDrawDataStride);
+
+   bool isEmpty() const {
+      return commands.empty();
+   }
+
+   const std::vector<Command>& getCommands() const {
+      return commands;
+   }
+
+   void bindProgram(ShaderProgram* program) {
+      addCommand(CommandType::kBindProgram, program, 0, 0);
+   }
+
+   void applyMaterials(ModelComponent* modelComponent) {
+      addCommand(CommandType::kApplyMaterials, modelComponent, 0, 0);
+   }
+
+   void draw(Mesh* mesh, const glm::mat4& modelMatrix, const glm::mat4& normalMatrix);
+
+   /**
+    * Adds an instanced draw and returns the instance data to fill in (valid until the next command is added)
+    */
+   Mesh::InstanceData* drawInstanced(Mesh* mesh, std::uint32_t numInstances);
+
+   /**
+    * Uploads the per-draw data and executes the commands. Materials are applied with copies of the render data.
+    */
+   void replay(const RenderData& renderData);
+
+private:
+   void addCommand(CommandType type, void* object, std::uint32_t index, std::uint32_t count) {
+      Command command;
+      command.object = object;
+      command.index = index;
+      command.count = count;
+      command.type = type;
+
+      commands.push_back(command);
+   }
+
+   const DrawUniformData& getDrawData(std::uint32_t slot) const {
+      return *reinterpret_cast<const DrawUniformData*>(drawData.data() + slot * drawDataStride);
+   }
+
+   std::vector<Command> commands;
+   std::vector<Mesh::InstanceData> instances;
+
+   // Per-draw data slots, drawDataStride bytes apart
+   std::vector<unsigned char> drawData;
+   std::size_t drawDataStride;
+   std::uint32_t numDrawDataSlots;
+
+   // Created on first replay, so that lists can be recorded without a GL context
+   GLuint drawBuffer;
+   std::size_t drawBufferSize;
+};
+
+} // namespace Shiny
+
+#endif
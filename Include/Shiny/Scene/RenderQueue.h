@@ -0,0 +1,134 @@
+#ifndef SHINY_RENDER_QUEUE_H
+#define SHINY_RENDER_QUEUE_H
+
+#include "Shiny/Pointers.h"
+#include "Shiny/Graphics/RenderData.h"
+#include "Shiny/Math/Bounds.h"
+#include "Shiny/Scene/RenderCommandList.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace Shiny {
+
+class CameraComponent;
+class ModelComponent;
+class Scene;
+class ThreadPool;
+
+/**
+ * Per-frame list of draws, ordered by 64-bit sort keys so that draws sharing a shader program, material and mesh are
+ * submitted together. From the most significant bits down, opaque keys hold the pass, the translucency bit (clear), the
+ * program, material and mesh, then the view depth (front to back). Translucent keys hold the pass, the translucency bit
+ * (set) and the inverted view depth (back to front), then the program, material and mesh.
+ *
+ * queue.clear();
+ * queue.addScene(scene, camera);
+ * queue.sort();
+ * queue.submit(renderData);
+ */
+class RenderQueue {
+public:
+   using SortKey = std::uint64_t;
+
+   static const std::uint8_t kMaxPass = 7;
+
+   // Bounds the size of the per-mesh instance buffers
+   static const std::size_t kMaxInstancesPerDraw = 4096;
+
+   // Fewer draws than this per thread are recorded without splitting the queue
+   static const std::size_t kMinDrawsPerSlice = 256;
+
+   /**
+    * Which draws a queue accepts. G-buffer queues only take opaque models with a G-buffer program (and sort and draw
+    * them by it). Deferred remainder queues take every model a G-buffer queue leaves out, so that together the two draw
+    * each model once.
+    */
+   enum class Mode {
+      kForward,
+      kGBuffer,
+      kDeferredRemainder
+   };
+
+   static SortKey makeKey(std::uint8_t pass, bool translucent, std::uint32_t programId, std::uint32_t materialId, std::uint32_t meshId, float viewDepth);
+
+   RenderQueue(Mode queueMode = Mode::kForward)
+      : mode(queueMode) {
+   }
+
+   Mode getMode() const {
+      return mode;
+   }
+
+   void clear() {
+      items.clear();
+   }
+
+   std::size_t size() const {
+      return items.size();
+   }
+
+   /**
+    * Adds a draw of the model component, with the given distance from the viewer along the view direction
+    */
+   void add(ModelComponent* modelComponent, float viewDepth, std::uint8_t pass = 0);
+
+   /**
+    * Adds a draw of every model component in the scene
+    */
+   void addScene(const Scene& scene, const glm::vec3& viewPosition, const glm::vec3& viewDirection, std::uint8_t pass = 0);
+
+   /**
+    * Adds a draw of every model component in the scene whose bounds intersect the camera's frustum (using the scene's
+    * spatial index, so call Scene::updateTransforms() first). Models the index returns are culled again by their tight
+    * bounding spheres, since the index only stores loose boxes.
+    */
+   void addScene(const Scene& scene, const CameraComponent& camera, std::uint8_t pass = 0);
+
+   /**
+    * Orders all draws by key (stable radix sort)
+    */
+   void sort();
+
+   /**
+    * Renders all draws in key order. Call sort() first. Adjacent draws with the same mesh, program and materials are
+    * combined into instanced draws when the program supports instancing. G-buffer queues draw with the G-buffer
+    * programs.
+    *
+    * The draws are first recorded into command lists, then replayed on the calling thread (which must own the GL
+    * context). With a thread pool, slices of the queue are recorded in parallel. Stale world matrices are updated
+    * before recording starts, and the workers only read them, so the scene's transforms must not change during the
+    * call.
+    */
+   void submit(const RenderData& renderData, ThreadPool* threadPool = nullptr);
+
+private:
+   struct Item {
+      SortKey key;
+      ModelComponent* modelComponent;
+   };
+
+   /**
+    * Records the draws in [begin, end) into the command list
+    */
+   void record(RenderCommandList& commandList, const RenderData& renderData, std::size_t begin, std::size_t end) const;
+
+   Mode mode;
+
+   std::vector<Item> items;
+   std::vector<Item> scratchItems;
+
+   // Models the spatial index found in the frustum, and which of them are visible, reused every frame
+   std::vector<ModelComponent*> candidateModelComponents;
+   std::vector<BoundingSphere> candidateSpheres;
+   std::vector<std::uint32_t> visibleCandidates;
+
+   // One list per slice of the queue, reused every frame
+   std::vector<UPtr<RenderCommandList>> commandLists;
+};
+
+} // namespace Shiny
+
+#endif
@@ -2,10 +2,20 @@
 #define SHINY_SCENE_H
 
 #include "Shiny/Pointers.h"
+#include "Shiny/Entity/ComponentStorage.h"
 #include "Shiny/Entity/Entity.h"
+#include "Shiny/Entity/EntityHandle.h"
+#include "Shiny/Graphics/FrameUniforms.h"
+#include "Shiny/Math/DynamicBvh.h"
 #include "Shiny/Scene/ModelComponent.h"
+#include "Shiny/Scene/SceneView.h"
+#include "Shiny/Scene/TransformHierarchy.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -14,48 +24,154 @@ namespace Shiny {
 
 class CameraComponent;
 class LightComponent;
-class ShaderProgram;
+class Prefab;
+class SceneCommandBuffer;
+class ThreadPool;
 
 class Scene {
 public:
-   Scene()
-      : activeCamera(nullptr) {
-   }
+   using InstantiateFunc = std::function<void(Entity& entity, std::size_t index)>;
 
-   ~Scene() {
-      for (const auto& entity : entities) {
-         entity->executeDestroy();
-      }
-      entities.clear();
-   }
+   Scene();
+
+   ~Scene();
 
    template<typename... ComponentTypes>
    Entity* createEntity() {
-      entities.push_back(Entity::create<ComponentTypes...>(*this));
-      return entities.back().get();
+      EntityHandle handle = allocateEntitySlot();
+      return addEntity(Entity::create<ComponentTypes...>(*this, componentStore, handle));
    }
 
    Entity* createEntity(const std::vector<std::string>& componentClassNames) {
-      entities.push_back(Entity::create(componentClassNames, *this));
-      return entities.back().get();
+      EntityHandle handle = allocateEntitySlot();
+      return addEntity(Entity::create(componentClassNames, *this, componentStore, handle));
    }
 
+   /**
+    * Spawns count entities from the prefab. Storage is reserved up front, components are constructed one type at a time,
+    * and then every entity is initialized (prefab component init functions, onOwnerInitialized(), then the given init
+    * function, which receives the index of the entity within the batch). Init functions must not destroy entities
+    * directly - use the command buffer instead.
+    */
+   void instantiate(const Prefab& prefab, std::size_t count, const InstantiateFunc& initFunction = nullptr);
+
+   /**
+    * Returns all live entities. Destroying an entity moves the last entity into its place, so the order is not stable.
+    */
    const std::vector<UPtr<Entity>>& getEntities() const {
       return entities;
    }
 
+   /**
+    * Returns the entity referred to by the handle, or null if the entity has been destroyed
+    */
+   Entity* getEntity(EntityHandle handle) const {
+      if (handle.index >= entitySlots.size()) {
+         return nullptr;
+      }
+
+      const EntitySlot& slot = entitySlots[handle.index];
+      if (slot.generation != handle.generation || slot.denseIndex == EntityHandle::kInvalidIndex) {
+         return nullptr;
+      }
+
+      return entities[slot.denseIndex].get();
+   }
+
+   bool isValid(EntityHandle handle) const {
+      return getEntity(handle) != nullptr;
+   }
+
+   /**
+    * Returns all live components of exactly type T (not subclasses of T), which are stored contiguously per type
+    */
+   template<typename T>
+   const std::vector<T*>& getComponents() const {
+      // Doesn't create storage, so that systems running in parallel can safely query component types that don't exist
+      static const std::vector<T*> kNoComponents;
+
+      const ComponentStorage<T>* storage = componentStore.findStorage<T>();
+      return storage ? storage->getComponents() : kNoComponents;
+   }
+
+   /**
+    * Returns a view over all entities that have (at least) the given component types
+    */
+   template<typename... ComponentTypes>
+   SceneView<ComponentTypes...> view() {
+      return SceneView<ComponentTypes...>(*this);
+   }
+
+   bool destroyEntity(EntityHandle handle);
+
    bool destroyEntity(Entity* entityToDestroy) {
-      auto itr = std::find_if(entities.begin(), entities.end(), [entityToDestroy](const UPtr<Entity>& entity) {
-         return entity.get() == entityToDestroy;
-      });
-
-      if (itr != entities.end()) {
-         (*itr)->executeDestroy();
-         entities.erase(itr);
-         return true;
+      if (!entityToDestroy || &entityToDestroy->getScene() != this) {
+         return false;
       }
 
-      return false;
+      return destroyEntity(entityToDestroy->getHandle());
+   }
+
+   /**
+    * Makes sure that at least the given number of entities can exist without reallocating entity bookkeeping
+    */
+   void reserveEntities(std::size_t count) {
+      entities.reserve(count);
+      entitySlots.reserve(count);
+   }
+
+   /**
+    * Command buffer owned by the scene, applied by flushCommands()
+    */
+   SceneCommandBuffer& getCommandBuffer() {
+      return *commandBuffer;
+   }
+
+   /**
+    * Sync point - applies all commands recorded in the scene's command buffer. Destroys are applied first, then
+    * component removals, then component additions, and finally spawns.
+    */
+   void flushCommands() {
+      flushCommands(*commandBuffer);
+   }
+
+   void flushCommands(SceneCommandBuffer& buffer);
+
+   TransformHierarchy& getTransformHierarchy() {
+      return transformHierarchy;
+   }
+
+   /**
+    * Recomputes the world transforms of everything that moved since the last update, one depth level at a time, then
+    * updates the spatial indices. Should be called once per frame, after gameplay updates and before rendering.
+    */
+   void updateTransforms(ThreadPool* threadPool = nullptr) {
+      transformHierarchy.update(threadPool);
+      updateSpatialIndices();
+   }
+
+   /**
+    * Spatial index of all model components with bounds (user data is the ModelComponent*). Up to date as of the last
+    * updateTransforms() call.
+    */
+   const DynamicBvh& getModelSpatialIndex() const {
+      return modelSpatialIndex;
+   }
+
+   /**
+    * Model components without bounds (e.g. without a mesh), which aren't in the spatial index. Kept up to date as
+    * models are registered and their meshes change.
+    */
+   const std::vector<ModelComponent*>& getUnboundedModelComponents() const {
+      return unboundedModelComponents;
+   }
+
+   /**
+    * Spatial index of all lights with a limited range (user data is the LightComponent*). Up to date as of the last
+    * updateTransforms() call.
+    */
+   const DynamicBvh& getLightSpatialIndex() const {
+      return lightSpatialIndex;
    }
 
    void setActiveCamera(CameraComponent* newCamera) {
@@ -68,33 +184,140 @@ public:
 
    void registerModelComponent(ModelComponent* modelComponent);
 
-   const std::unordered_map<ShaderProgram*, std::vector<ModelComponent*>>& getModelComponentsByShaderProgram() const {
-      return modelComponentsByShaderProgram;
+   /**
+    * Returns all model components, in no particular order (use a RenderQueue to order draws)
+    */
+   const std::vector<ModelComponent*>& getModelComponents() const {
+      return modelComponents;
    }
 
    void registerLightComponent(LightComponent* lightComponent);
 
-   const std::vector<LightComponent*> getLightComponents() const {
+   const std::vector<LightComponent*>& getLightComponents() const {
       return lightComponents;
    }
 
+   /**
+    * Fills the ShinyFrame uniform block from the active camera and the scene's lights, and uploads it (once, for all
+    * shader programs). Lights without a limited range come first, followed by those that intersect the camera's
+    * frustum, up to FrameUniforms::kMaxLights. Should be called once per frame, after updateTransforms().
+    */
+   void updateFrameUniforms();
+
+   const FrameUniformData& getFrameUniformData() const {
+      return frameUniformData;
+   }
+
 private:
-   struct ModelComponentHandles {
+   friend class Entity;
+   friend class ModelComponent;
+   template<typename... ComponentTypes> friend class SceneView;
+
+   struct EntitySlot {
+      EntitySlot()
+         : generation(1), denseIndex(EntityHandle::kInvalidIndex) {
+      }
+
+      std::uint32_t generation;
+      std::uint32_t denseIndex;
+   };
+
+   void reserveAdditionalEntities(std::size_t additionalCount);
+   EntityHandle allocateEntitySlot();
+   Entity* addEntity(UPtr<Entity> entity);
+
+   /**
+    * Returns the cached query for the given filter, creating it if this is the first view using the filter. Safe to call
+    * from systems running in parallel (lookups don't lock, creating a query does).
+    */
+   EntityQuery& getQuery(const ViewFilter& filter);
+
+   EntityQuery* findQuery(const ViewFilter& filter) const;
+
+   void updateViews(Entity& entity);
+
+   void updateSpatialIndices();
+
+   /**
+    * Moves the model between the spatial index and the unbounded models, depending on whether it has bounds
+    */
+   void onModelBoundsChanged(ModelComponent* modelComponent);
+   void removeUnboundedModelComponent(ModelComponent* modelComponent);
+
+   /**
+    * Queues the model's proxy to be moved by the next updateSpatialIndices()
+    */
+   void onModelMoved(ModelComponent* modelComponent);
+
+   struct LightComponentEntry {
+      LightComponentEntry()
+         : index(0), proxyId(DynamicBvh::kNullProxy) {
+      }
+
       Component::OnDestroyDelegate::Handle onDestroyHandle;
-      ModelComponent::OnShaderProgramChangeDelegate::Handle onShaderProgramChangeHandle;
+      std::size_t index;
+      DynamicBvh::ProxyId proxyId;
    };
 
+   struct ModelComponentEntry {
+      ModelComponentEntry()
+         : index(0) {
+      }
+
+      Component::OnDestroyDelegate::Handle onDestroyHandle;
+      std::size_t index;
+   };
+
+   // Declared before the entities so that the transform hierarchy and component storage outlive them
+   TransformHierarchy transformHierarchy;
+   ComponentStore componentStore;
    std::vector<UPtr<Entity>> entities;
+   std::vector<EntitySlot> entitySlots;
+   std::vector<std::uint32_t> freeEntitySlots;
 
-   std::unordered_map<ShaderProgram*, std::vector<ModelComponent*>> modelComponentsByShaderProgram;
-   std::unordered_map<ModelComponent*, ModelComponentHandles> modelComponentHandles;
+   UPtr<SceneCommandBuffer> commandBuffer;
+
+   // Queries are never removed, and new ones are fully built before being published at the head of the list, so
+   // lookups can walk the list while another thread adds a query. Only adding takes the mutex.
+   struct QueryNode {
+      QueryNode(const ViewFilter& filter, QueryNode* inNext)
+         : query(filter), next(inNext) {
+      }
+
+      EntityQuery query;
+      QueryNode* next;
+   };
+
+   std::vector<UPtr<QueryNode>> queryNodes;
+   std::atomic<QueryNode*> queryListHead;
+   std::mutex queryMutex;
+
+   std::vector<ModelComponent*> modelComponents;
+   std::unordered_map<ModelComponent*, ModelComponentEntry> modelComponentEntries;
+   std::vector<ModelComponent*> unboundedModelComponents;
+   DynamicBvh modelSpatialIndex;
+
+   // Models with bounds that moved (or got bounds) since the last updateSpatialIndices(). Transforms can be set by
+   // systems running in parallel, so this is locked.
+   std::vector<ModelComponent*> pendingSpatialModelComponents;
+   std::mutex pendingSpatialMutex;
 
    std::vector<LightComponent*> lightComponents;
-   std::unordered_map<LightComponent*, Component::OnDestroyDelegate::Handle> lightComponentDestroyHandles;
+   std::unordered_map<LightComponent*, LightComponentEntry> lightComponentEntries;
+   DynamicBvh lightSpatialIndex;
+
+   // Created on first use, so that scenes can exist without a GL context
+   UPtr<FrameUniformBuffer> frameUniformBuffer;
+   FrameUniformData frameUniformData;
 
    CameraComponent* activeCamera;
 };
 
+template<typename... ComponentTypes>
+EntityQuery& SceneView<ComponentTypes...>::getQuery() const {
+   return scene.getQuery(filter);
+}
+
 } // namespace Shiny
 
 #endif
@@ -0,0 +1,140 @@
+#ifndef SHINY_SCENE_COMMAND_BUFFER_H
+#define SHINY_SCENE_COMMAND_BUFFER_H
+
+#include "Shiny/Entity/Entity.h"
+#include "Shiny/Entity/EntityHandle.h"
+#include "Shiny/Scene/Scene.h"
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Shiny {
+
+/**
+ * Records structural changes to a scene (spawning / destroying entities, adding / removing components) so that they
+ * can be applied later, in bulk, by Scene::flushCommands(). Recording is thread safe; applying happens on the thread
+ * that flushes.
+ */
+class SceneCommandBuffer {
+public:
+   using EntityInitFunc = std::function<void(Entity&)>;
+
+   template<typename T>
+   using ComponentInitFunc = std::function<void(T&)>;
+
+   SceneCommandBuffer() = default;
+   SceneCommandBuffer(const SceneCommandBuffer& other) = delete;
+   SceneCommandBuffer(SceneCommandBuffer&& other) = delete;
+   SceneCommandBuffer& operator=(const SceneCommandBuffer& other) = delete;
+   SceneCommandBuffer& operator=(SceneCommandBuffer&& other) = delete;
+
+   template<typename... ComponentTypes>
+   void spawn(const EntityInitFunc& initFunction = nullptr) {
+      std::lock_guard<std::mutex> lock(mutex);
+      commands.spawns.push_back({ &createEntity<ComponentTypes...>, {}, initFunction });
+   }
+
+   void spawn(const std::vector<std::string>& componentClassNames, const EntityInitFunc& initFunction = nullptr) {
+      std::lock_guard<std::mutex> lock(mutex);
+      commands.spawns.push_back({ nullptr, componentClassNames, initFunction });
+   }
+
+   void destroyEntity(EntityHandle handle) {
+      std::lock_guard<std::mutex> lock(mutex);
+      commands.destroys.push_back(handle);
+   }
+
+   template<typename T>
+   void addComponent(EntityHandle handle, const ComponentInitFunc<T>& initFunction = nullptr) {
+      std::function<void(Component&)> componentInitFunction;
+      if (initFunction) {
+         componentInitFunction = [initFunction](Component& component) {
+            initFunction(static_cast<T&>(component));
+         };
+      }
+
+      std::lock_guard<std::mutex> lock(mutex);
+      commands.adds.push_back({ handle, &createComponent<T>, {}, std::move(componentInitFunction) });
+   }
+
+   void addComponent(EntityHandle handle, const std::string& className) {
+      std::lock_guard<std::mutex> lock(mutex);
+      commands.adds.push_back({ handle, nullptr, className, nullptr });
+   }
+
+   /**
+    * Removes the first component that is a T (including subclasses of T) from the entity
+    */
+   template<typename T>
+   void removeComponent(EntityHandle handle) {
+      std::lock_guard<std::mutex> lock(mutex);
+      commands.removes.push_back({ handle, &destroyComponent<T> });
+   }
+
+   bool isEmpty() const {
+      std::lock_guard<std::mutex> lock(mutex);
+      return commands.spawns.empty() && commands.destroys.empty() && commands.adds.empty() && commands.removes.empty();
+   }
+
+private:
+   friend class Scene;
+
+   struct SpawnCommand {
+      Entity* (*createFunction)(Scene&);
+      std::vector<std::string> componentClassNames;
+      EntityInitFunc initFunction;
+   };
+
+   struct AddComponentCommand {
+      EntityHandle handle;
+      Component* (*createFunction)(Entity&);
+      std::string className;
+      std::function<void(Component&)> initFunction;
+   };
+
+   struct RemoveComponentCommand {
+      EntityHandle handle;
+      bool (*destroyFunction)(Entity&);
+   };
+
+   struct Commands {
+      std::vector<SpawnCommand> spawns;
+      std::vector<EntityHandle> destroys;
+      std::vector<AddComponentCommand> adds;
+      std::vector<RemoveComponentCommand> removes;
+   };
+
+   template<typename... ComponentTypes>
+   static Entity* createEntity(Scene& scene) {
+      return scene.createEntity<ComponentTypes...>();
+   }
+
+   template<typename T>
+   static Component* createComponent(Entity& entity) {
+      return entity.createComponent<T>();
+   }
+
+   template<typename T>
+   static bool destroyComponent(Entity& entity) {
+      T* component = entity.getComponentByClass<T>();
+      return component && entity.destroyComponent(component);
+   }
+
+   /**
+    * Moves all recorded commands into the given (empty) command list, so that commands recorded while applying them
+    * end up in the next flush
+    */
+   void takeCommands(Commands& takenCommands) {
+      std::lock_guard<std::mutex> lock(mutex);
+      std::swap(commands, takenCommands);
+   }
+
+   mutable std::mutex mutex;
+   Commands commands;
+};
+
+} // namespace Shiny
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef SHINY_SCENE_RENDERER_H
+#define SHINY_SCENE_RENDERER_H
+
+#include "Shiny/Pointers.h"
+#include "Shiny/Graphics/OpenGL.h"
+#include "Shiny/Graphics/ShaderProgram.h"
+#include "Shiny/Scene/RenderQueue.h"
+
+#include <glm/glm.hpp>
+
+namespace Shiny {
+
+class CameraComponent;
+class Framebuffer;
+class LightComponent;
+class Mesh;
+class RenderData;
+class Scene;
+class Texture;
+class ThreadPool;
+
+enum class RenderPath {
+   // Models are shaded as they are drawn
+   kForward,
+
+   // Models write a G-buffer once, then lighting is accumulated per covered pixel
+   kDeferred
+};
+
+/**
+ * Renders a scene from its active camera, with the path chosen per call.
+ *
+ * The deferred path draws every opaque model that has a G-buffer program (ModelComponent::setGBufferShaderProgram())
+ * into a G-buffer, then shades it. Ambient and directional lights (from the ShinyFrame block) are applied in a single
+ * full screen pass, while point and spot lights visible to the camera are drawn as light volumes (spheres, or cones for
+ * narrow spot lights), so their cost scales with the pixels they cover. Point and spot lights without falloff reach
+ * everything, so they are applied in the full screen pass too. Remaining models (translucent ones, or those without a
+ * G-buffer program) are then drawn forward, depth tested against the G-buffer's depth. G-buffer programs write:
+ *
+ * layout(location = 0) out vec4 gAlbedo;    // rgb = diffuse color, a = emission (scales the diffuse color)
+ * layout(location = 1) out vec4 gNormal;    // rgb = world space normal, a = shininess
+ * layout(location = 2) out vec4 gMaterial;  // rgb = specular color
+ */
+class SceneRenderer {
+public:
+   enum GBufferAttachment : std::size_t {
+      kAlbedo = 0,
+      kNormal = 1,
+      kMaterial = 2
+   };
+
+   SceneRenderer();
+   SceneRenderer(const SceneRenderer& other) = delete;
+   SceneRenderer(SceneRenderer&& other) = delete;
+
+   ~SceneRenderer();
+
+   SceneRenderer& operator=(const SceneRenderer& other) = delete;
+   SceneRenderer& operator=(SceneRenderer&& other) = delete;
+
+   /**
+    * Renders the scene into the target (or the default framebuffer if null), which isn't cleared. Updates the
+    * ShinyFrame block, so call Scene::updateTransforms() first. The deferred path replaces the target's depth with the
+    * G-buffer's (the depth / stencil formats must match).
+    */
+   void render(Scene& scene, RenderPath path, Framebuffer* target = nullptr);
+
+   /**
+    * Pool that render queues are recorded on (see RenderQueue::submit()), or null to record on the calling thread
+    */
+   void setThreadPool(ThreadPool* newThreadPool) {
+      threadPool = newThreadPool;
+   }
+
+   /**
+    * G-buffer written by the last deferred render (null before the first one)
+    */
+   const Framebuffer* getGBuffer() const {
+      return gBuffer.get();
+   }
+
+private:
+   void renderForward(Scene& scene, const CameraComponent& camera, Framebuffer* target);
+   void renderDeferred(Scene& scene, const CameraComponent& camera, Framebuffer* target);
+
+   void prepareGBuffer(GLsizei width, GLsizei height);
+   void prepareLighting();
+
+   void renderLighting(const Scene& scene, const CameraComponent& camera, bool depthTested);
+   void renderLightVolume(const LightComponent& light, const glm::mat4& viewProjMatrix);
+   void bindGBufferTexture(RenderData& renderData, const UniformHandle<GLint>& uniform, const SPtr<Texture>& texture);
+
+   ThreadPool* threadPool;
+
+   RenderQueue forwardQueue;
+   RenderQueue gBufferQueue;
+   RenderQueue remainderQueue;
+
+   UPtr<Framebuffer> gBuffer;
+
+   // Created on first use, so that renderers can exist without a GL context
+   SPtr<ShaderProgram> lightingProgram;
+   UPtr<Mesh> fullscreenMesh;
+   UPtr<Mesh> sphereMesh;
+   UPtr<Mesh> coneMesh;
+
+   UniformHandle<glm::mat4> transformUniform;
+   UniformHandle<glm::mat4> inverseViewProjUniform;
+   UniformHandle<bool> lightVolumeUniform;
+   UniformHandle<glm::vec4> lightColorUniform;
+   UniformHandle<glm::vec4> lightPositionFalloffUniform;
+   UniformHandle<glm::vec4> lightDirectionBeamUniform;
+   UniformHandle<glm::vec4> lightCutoffUniform;
+   UniformHandle<GLint> albedoUniform;
+   UniformHandle<GLint> normalUniform;
+   UniformHandle<GLint> materialUniform;
+   UniformHandle<GLint> depthUniform;
+};
+
+} // namespace Shiny
+
+#endif
@@ -0,0 +1,176 @@
+#ifndef SHINY_SCENE_VIEW_H
+#define SHINY_SCENE_VIEW_H
+
+#include "Shiny/Entity/ComponentType.h"
+#include "Shiny/Entity/Entity.h"
+#include "Shiny/Entity/EntityHandle.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Shiny {
+
+class Scene;
+
+/**
+ * Describes which entities a view matches: all of the required component types (or subclasses of them) and tags, and
+ * none of the excluded ones
+ */
+struct ViewFilter {
+   ComponentTypeMask requiredTypes = 0;
+   ComponentTypeMask excludedTypes = 0;
+   EntityTagMask requiredTags = 0;
+   EntityTagMask excludedTags = 0;
+
+   bool matches(const Entity& entity) const {
+      ComponentTypeMask typeMask = entity.getComponentTypeMask();
+      EntityTagMask tags = entity.getTags();
+
+      return (typeMask & requiredTypes) == requiredTypes && (typeMask & excludedTypes) == 0
+         && (tags & requiredTags) == requiredTags && (tags & excludedTags) == 0;
+   }
+
+   bool operator==(const ViewFilter& other) const {
+      return requiredTypes == other.requiredTypes && excludedTypes == other.excludedTypes
+         && requiredTags == other.requiredTags && excludedTags == other.excludedTags;
+   }
+};
+
+/**
+ * Cached set of entities matching a filter. Owned by the scene, which keeps it up to date as entities are created,
+ * destroyed, or change their component types / tags.
+ */
+class EntityQuery {
+public:
+   EntityQuery(const ViewFilter& inFilter)
+      : filter(inFilter) {
+   }
+
+   EntityQuery(const EntityQuery& other) = delete;
+   EntityQuery(EntityQuery&& other) = delete;
+   EntityQuery& operator=(const EntityQuery& other) = delete;
+   EntityQuery& operator=(EntityQuery&& other) = delete;
+
+   const ViewFilter& getFilter() const {
+      return filter;
+   }
+
+   const std::vector<Entity*>& getEntities() const {
+      return entities;
+   }
+
+   /**
+    * Adds or removes the entity depending on whether it currently matches the filter
+    */
+   void update(Entity& entity) {
+      bool matches = filter.matches(entity);
+      bool contained = contains(entity);
+
+      if (matches && !contained) {
+         add(entity);
+      } else if (!matches && contained) {
+         remove(entity);
+      }
+   }
+
+   void remove(Entity& entity) {
+      if (!contains(entity)) {
+         return;
+      }
+
+      std::uint32_t slotIndex = entity.getHandle().index;
+      std::uint32_t position = positions[slotIndex];
+
+      entities[position] = entities.back();
+      positions[entities[position]->getHandle().index] = position;
+      entities.pop_back();
+
+      positions[slotIndex] = EntityHandle::kInvalidIndex;
+   }
+
+private:
+   bool contains(const Entity& entity) const {
+      std::uint32_t slotIndex = entity.getHandle().index;
+      return slotIndex < positions.size() && positions[slotIndex] != EntityHandle::kInvalidIndex;
+   }
+
+   void add(Entity& entity) {
+      std::uint32_t slotIndex = entity.getHandle().index;
+      if (slotIndex >= positions.size()) {
+         positions.resize(slotIndex + 1, EntityHandle::kInvalidIndex);
+      }
+
+      positions[slotIndex] = static_cast<std::uint32_t>(entities.size());
+      entities.push_back(&entity);
+   }
+
+   const ViewFilter filter;
+   std::vector<Entity*> entities;
+
+   // Position of each entity in the entities vector, indexed by entity slot
+   std::vector<std::uint32_t> positions;
+};
+
+/**
+ * Iterates over the entities in a scene that have all of the given component types. Matches are cached by the scene,
+ * so iterating never visits non-matching entities. Structural changes made while iterating should go through the
+ * scene's SceneCommandBuffer. Views can be created from systems running in parallel - the first view with a new filter
+ * briefly locks the scene to build its cache.
+ *
+ * scene.view<TransformComponent, ModelComponent>().exclude<CameraComponent>().each([](Entity& entity, TransformComponent& transform, ModelComponent& model) { ... });
+ */
+template<typename... ComponentTypes>
+class SceneView {
+public:
+   SceneView(Scene& inScene)
+      : scene(inScene) {
+      int dummy[] = { 0, (filter.requiredTypes |= ComponentTypeInfo<ComponentTypes>::mask(), 0)... };
+      (void)dummy;
+   }
+
+   template<typename... ExcludedTypes>
+   SceneView& exclude() {
+      int dummy[] = { 0, (filter.excludedTypes |= ComponentTypeInfo<ExcludedTypes>::mask(), 0)... };
+      (void)dummy;
+      return *this;
+   }
+
+   SceneView& withTags(EntityTagMask tags) {
+      filter.requiredTags |= tags;
+      return *this;
+   }
+
+   SceneView& withoutTags(EntityTagMask tags) {
+      filter.excludedTags |= tags;
+      return *this;
+   }
+
+   const std::vector<Entity*>& getEntities() const {
+      return getQuery().getEntities();
+   }
+
+   std::size_t size() const {
+      return getEntities().size();
+   }
+
+   /**
+    * Calls the function with each matching entity and references to its components (the first component of each type)
+    */
+   template<typename Function>
+   void each(Function&& function) const {
+      for (Entity* entity : getEntities()) {
+         function(*entity, *entity->getComponentByClass<ComponentTypes>()...);
+      }
+   }
+
+private:
+   // Defined in Scene.h, since it needs the complete Scene
+   EntityQuery& getQuery() const;
+
+   Scene& scene;
+   ViewFilter filter;
+};
+
+} // namespace Shiny
+
+#endif
@@ -3,11 +3,20 @@
 
 #include "Shiny/Entity/Component.h"
 #include "Shiny/Math/Transform.h"
+#include "Shiny/Scene/TransformHierarchy.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
 
 namespace Shiny {
 
 class TransformComponent : public Component {
 public:
+   SHINY_DECLARE_COMPONENT(TransformComponent, Component)
+
+   ~TransformComponent();
+
    TransformComponent* getParent() {
       return parent;
    }
@@ -16,55 +25,88 @@ public:
       return parent;
    }
 
-   void setParent(TransformComponent* newParent) {
-      if (newParent && &getOwner() != &newParent->getOwner()) {
-         return;
-      }
-
-      parent = newParent;
-   }
-
-   Transform& getRelativeTransform() {
-      return relativeTransform;
-   }
+   void setParent(TransformComponent* newParent);
 
    const Transform& getRelativeTransform() const {
-      return relativeTransform;
+      return hierarchy.getLocalTransform(hierarchyIndex);
    }
 
    void setRelativeTransform(const Transform& newRelativeTransform) {
-      relativeTransform = newRelativeTransform;
+      hierarchy.setLocalTransform(hierarchyIndex, newRelativeTransform);
    }
 
-   Transform getAbsoluteTransform() const {
-      if (!parent) {
-         return relativeTransform;
-      }
-
-      return parent->getAbsoluteTransform() * relativeTransform;
+   /**
+    * World transform, computed by the scene's batched transform update (or on demand, if this component or one of its
+    * ancestors has changed since)
+    */
+   const Transform& getAbsoluteTransform() const {
+      return hierarchy.getWorldTransform(hierarchyIndex);
    }
 
    void setAbsoluteTransform(const Transform& newAbsoluteTransform) {
       if (!parent) {
-         relativeTransform = newAbsoluteTransform;
+         setRelativeTransform(newAbsoluteTransform);
          return;
       }
 
-      relativeTransform *= parent->getAbsoluteTransform().inverse();
+      setRelativeTransform(newAbsoluteTransform * parent->getAbsoluteTransform().inverse());
    }
 
-protected:
-   friend class ComponentRegistrar<TransformComponent>;
+   const glm::mat4& getWorldMatrix() const {
+      return hierarchy.getWorldMatrix(hierarchyIndex);
+   }
+
+   const glm::mat4& getNormalMatrix() const {
+      return hierarchy.getNormalMatrix(hierarchyIndex);
+   }
+
+   /**
+    * Recomputes the world data if this component or one of its ancestors has changed
+    */
+   void updateWorldData() const {
+      hierarchy.updateNodeAndAncestors(hierarchyIndex);
+   }
+
+   /**
+    * World / normal matrices as of the last update, without updating them (safe to read from worker threads, but the
+    * component must be up to date - see updateWorldData())
+    */
+   const glm::mat4& getCachedWorldMatrix() const {
+      return hierarchy.getCachedWorldMatrix(hierarchyIndex);
+   }
 
-   TransformComponent(Entity& entity)
-      : Component(entity), parent(nullptr) {
+   const glm::mat4& getCachedNormalMatrix() const {
+      return hierarchy.getCachedNormalMatrix(hierarchyIndex);
+   }
+
+   /**
+    * Changes whenever the world transform is recomputed, so that derived data (like spatial index bounds) can be
+    * refreshed only when needed
+    */
+   std::uint32_t getWorldStamp() const {
+      return hierarchy.getWorldStamp(hierarchyIndex);
    }
 
 protected:
-   Transform relativeTransform;
+   friend class ComponentRegistrar<TransformComponent>;
+
+   TransformComponent(Entity& entity);
+
+   /**
+    * Called when the world transform becomes stale (this component or one of its ancestors moved or was reparented), at
+    * most once until it is recomputed
+    */
+   virtual void onWorldTransformInvalidated() {
+   }
 
 private:
+   friend class TransformHierarchy;
+
+   TransformHierarchy& hierarchy;
+   TransformHierarchy::NodeIndex hierarchyIndex;
+
    TransformComponent* parent;
+   std::vector<TransformComponent*> children;
 };
 
 SHINY_REFERENCE_COMPONENT(TransformComponent)
@@ -0,0 +1,171 @@
+#ifndef SHINY_TRANSFORM_HIERARCHY_H
+#define SHINY_TRANSFORM_HIERARCHY_H
+
+#include "Shiny/ShinyAssert.h"
+#include "Shiny/Math/Transform.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace Shiny {
+
+class ThreadPool;
+class TransformComponent;
+
+/**
+ * Flattened transform hierarchy of a scene. Nodes are kept sorted by depth (all roots first, then all nodes at depth 1,
+ * and so on) in parallel arrays, so parents always come before their children and world transforms can be computed
+ * with a single linear pass (or one parallel pass per depth level). Inserting, removing and reparenting nodes patches
+ * the arrays by moving at most one node per depth level.
+ */
+class TransformHierarchy {
+public:
+   using NodeIndex = std::uint32_t;
+
+   static const NodeIndex kInvalidIndex = std::numeric_limits<NodeIndex>::max();
+
+   TransformHierarchy()
+      : stampCounter(0) {
+   }
+   TransformHierarchy(const TransformHierarchy& other) = delete;
+   TransformHierarchy(TransformHierarchy&& other) = delete;
+   TransformHierarchy& operator=(const TransformHierarchy& other) = delete;
+   TransformHierarchy& operator=(TransformHierarchy&& other) = delete;
+
+   std::size_t size() const {
+      return owners.size();
+   }
+
+   std::size_t getNumLevels() const {
+      return levelEnds.size();
+   }
+
+   /**
+    * Computes the world data of all dirty nodes, optionally spreading each depth level across the thread pool
+    */
+   void update(ThreadPool* threadPool = nullptr);
+
+private:
+   friend class TransformComponent;
+
+   /**
+    * Adds a root node, returning its index (which changes as the hierarchy is patched - the owner's index is kept up to
+    * date)
+    */
+   NodeIndex add(TransformComponent* owner);
+
+   /**
+    * Removes a node, which must not have any children
+    */
+   void remove(NodeIndex index);
+
+   /**
+    * Moves the owner's node (and all of its descendants) under the new parent's node. The owners' parent / child
+    * pointers must already reflect the new hierarchy.
+    */
+   void reparent(TransformComponent* owner);
+
+   const Transform& getLocalTransform(NodeIndex index) const {
+      return localTransforms[index];
+   }
+
+   void setLocalTransform(NodeIndex index, const Transform& transform) {
+      localTransforms[index] = transform;
+      markDirty(index);
+   }
+
+   const Transform& getWorldTransform(NodeIndex index) {
+      updateNodeAndAncestors(index);
+      return worldTransforms[index];
+   }
+
+   const glm::mat4& getWorldMatrix(NodeIndex index) {
+      updateNodeAndAncestors(index);
+      return worldMatrices[index];
+   }
+
+   const glm::mat4& getNormalMatrix(NodeIndex index) {
+      updateNodeAndAncestors(index);
+      return normalMatrices[index];
+   }
+
+   /**
+    * Read only versions of the accessors above, which never update the node, so they can be called from several threads
+    * at once. The node must already be up to date.
+    */
+   const glm::mat4& getCachedWorldMatrix(NodeIndex index) const {
+      ASSERT(!dirtyFlags[index], "Reading cached world matrix of a dirty node");
+      return worldMatrices[index];
+   }
+
+   const glm::mat4& getCachedNormalMatrix(NodeIndex index) const {
+      ASSERT(!dirtyFlags[index], "Reading cached normal matrix of a dirty node");
+      return normalMatrices[index];
+   }
+
+   /**
+    * Value that changes every time the node's world data is recomputed
+    */
+   std::uint32_t getWorldStamp(NodeIndex index) {
+      updateNodeAndAncestors(index);
+      return worldStamps[index];
+   }
+
+   void markDirty(NodeIndex index);
+
+   void updateNodeAndAncestors(NodeIndex index) {
+      if (dirtyFlags[index]) {
+         if (parentIndices[index] != kInvalidIndex) {
+            updateNodeAndAncestors(parentIndices[index]);
+         }
+
+         updateNode(index);
+      }
+   }
+
+   void updateNode(NodeIndex index) {
+      NodeIndex parentIndex = parentIndices[index];
+      worldTransforms[index] = parentIndex == kInvalidIndex ? localTransforms[index] : localTransforms[index] * worldTransforms[parentIndex];
+      worldMatrices[index] = worldTransforms[index].toMatrix();
+      normalMatrices[index] = worldTransforms[index].toNormalMatrix();
+      worldStamps[index] = ++stampCounter;
+      dirtyFlags[index] = 0;
+   }
+
+   /**
+    * Updates all dirty nodes in the range, batching runs of consecutive dirty nodes
+    */
+   void updateRange(NodeIndex begin, NodeIndex end);
+
+   NodeIndex getLevelBegin(std::uint32_t depth) const {
+      return depth == 0 ? 0 : levelEnds[depth - 1];
+   }
+
+   NodeIndex insertAtDepth(std::uint32_t depth, TransformComponent* owner, NodeIndex parentIndex, const Transform& localTransform);
+   void moveNode(NodeIndex from, NodeIndex to);
+   void collectSubtree(TransformComponent* owner, std::vector<TransformComponent*>& subtree) const;
+
+   // Per-node data, indexed by node index
+   std::vector<Transform> localTransforms;
+   std::vector<NodeIndex> parentIndices;
+   std::vector<Transform> worldTransforms;
+   std::vector<glm::mat4> worldMatrices;
+   std::vector<glm::mat4> normalMatrices;
+   std::vector<std::uint8_t> dirtyFlags;
+   std::vector<std::uint32_t> worldStamps;
+   std::vector<std::uint32_t> depths;
+   std::vector<TransformComponent*> owners;
+
+   // End (exclusive) of each depth level
+   std::vector<NodeIndex> levelEnds;
+
+   // Incremented for every batched update pass (shared by all nodes it recomputes) and every on demand update
+   std::uint32_t stampCounter;
+};
+
+} // namespace Shiny
+
+#endif
@@ -108,9 +108,14 @@ SPtr<Mesh> meshFromStream(std::istream& in, bool generateNormalsIfMissing) {
       numNormals = static_cast<unsigned int>(generatedNormals.size());
    }
 
-   return std::make_shared<Mesh>(attributes.vertices.data(), numVertices, normals, numNormals,
-                                 attributes.texcoords.data(), numTexCoords, indices.data(), numIndices,
-                                 dimensionality);
+   SPtr<Mesh> mesh = std::make_shared<Mesh>(attributes.vertices.data(), numVertices, normals, numNormals,
+                                            attributes.texcoords.data(), numTexCoords, indices.data(), numIndices,
+                                            dimensionality);
+
+   BoundingBox boundingBox = BoundingBox::fromPoints(attributes.vertices.data(), numVertices, dimensionality);
+   mesh->setLocalBounds(boundingBox, BoundingSphere::fromPoints(boundingBox, attributes.vertices.data(), numVertices, dimensionality));
+
+   return mesh;
 }
 
 SPtr<Mesh> getMeshFromMemory(const char* data) {
@@ -24,6 +24,14 @@ const char* kVertexExtension = ".vert";
 const char* kGeometryExtension = ".geom";
 const char* kFragmentExtension = ".frag";
 
+ShaderDefinitions withDefaultDefinitions(const ShaderDefinitions& definitions) {
+   ShaderDefinitions allDefinitions = definitions;
+   allDefinitions.emplace(ShaderLoader::kInstancingDefinition, "0");
+   allDefinitions.emplace(ShaderLoader::kGBufferDefinition, "0");
+
+   return allDefinitions;
+}
+
 const char* kDefaultVertexSource = GLSL(
    uniform mat4 uModelMatrix;
    uniform mat4 uViewMatrix;
@@ -242,20 +250,26 @@ std::string loadShaderSource(const Path& path, const std::unordered_map<std::str
 
 } // namespace
 
+// static
+const char* const ShaderLoader::kInstancingDefinition = "SHINY_INSTANCED";
+
+// static
+const char* const ShaderLoader::kGBufferDefinition = "SHINY_GBUFFER";
+
 SPtr<Shader> ShaderLoader::loadShader(const Path& path, const GLenum type, const std::unordered_map<std::string, std::string>& definitions) {
    ASSERT(type == GL_VERTEX_SHADER || type == GL_GEOMETRY_SHADER || type == GL_FRAGMENT_SHADER,
           "Invalid shader type: %i", type);
 
    ShaderPermutation shaderPermutation;
    shaderPermutation.path = path;
-   shaderPermutation.definitions = definitions;
+   shaderPermutation.definitions = withDefaultDefinitions(definitions);
 
    auto location = shaderMap.find(shaderPermutation);
    if (location != shaderMap.end()) {
       return location->second;
    }
 
-   std::string source = loadShaderSource(path, definitions);
+   std::string source = loadShaderSource(path, shaderPermutation.definitions);
    if (source.empty()) {
       LOG_WARNING("Reverting to default shader (instead of " << path << ")");
       return getDefaultShader(type);
@@ -276,7 +290,7 @@ SPtr<Shader> ShaderLoader::loadShader(const Path& path, const GLenum type, const
 SPtr<ShaderProgram> ShaderLoader::loadShaderProgram(const Path& path, const std::unordered_map<std::string, std::string>& definitions) {
    ShaderPermutation shaderPermutation;
    shaderPermutation.path = path;
-   shaderPermutation.definitions = definitions;
+   shaderPermutation.definitions = withDefaultDefinitions(definitions);
 
    auto location = shaderProgramMap.find(shaderPermutation);
    if (location != shaderProgramMap.end()) {
@@ -327,8 +341,9 @@ void ShaderLoader::reloadShaders() {
       const ShaderPermutation& shaderPermutation = pair.first;
       const SPtr<Shader>& shader = pair.second;
 
-      std::string source;
-      if (!IOUtils::readTextFile(shaderPermutation.path, source)) {
+      // Process includes and definitions the same way as the initial load
+      std::string source = loadShaderSource(shaderPermutation.path, shaderPermutation.definitions);
+      if (source.empty()) {
          LOG_WARNING("Unable to load shader from file \"" << shaderPermutation.path << "\", not reloading");
          continue;
       }
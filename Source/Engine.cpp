@@ -89,7 +89,7 @@ void Engine::windowFocusCallback(GLFWwindow *window, int focused) {
 }
 
 Engine::Engine()
-   : window(nullptr), running(false), runningTime(0.0f) {
+   : window(nullptr), systemScheduler(threadPool), scene(nullptr), running(false), runningTime(0.0f) {
    controllers.fill(nullptr);
 }
 
@@ -204,11 +204,15 @@ void Engine::run() {
          pollInput();
 
          tick(static_cast<float>(dt));
+         if (scene) {
+            systemScheduler.run(*scene, static_cast<float>(dt));
+         }
          runningTime += static_cast<float>(dt);
          accumulator -= dt;
       }
 
       render();
+      context.endFrame();
 
       glfwSwapBuffers(window.get());
    }
@@ -237,4 +241,13 @@ float Engine::getRunningTime() const {
    return runningTime;
 }
 
+const GpuProfile& Engine::getGpuProfile() const {
+#if SHINY_GPU_PROFILING
+   return context.getGpuProfiler().getProfile();
+#else
+   static const GpuProfile kEmptyProfile;
+   return kEmptyProfile;
+#endif // SHINY_GPU_PROFILING
+}
+
 } // namespace Shiny
@@ -1,9 +1,32 @@
+#include "Shiny/Log.h"
 #include "Shiny/ShinyAssert.h"
 #include "Shiny/Entity/Component.h"
 #include "Shiny/Entity/Entity.h"
 
+#include <atomic>
+#include <cstdlib>
+
 namespace Shiny {
 
+namespace ComponentTypes {
+
+ComponentTypeId allocateId() {
+   // Types that aren't registered get their IDs lazily, possibly from systems running in parallel
+   static std::atomic<ComponentTypeId> nextId(0);
+
+   ComponentTypeId id = nextId.fetch_add(1);
+
+   // IDs index fixed size tables and 64-bit masks, so this has to hold in release builds too
+   if (id >= kMaxComponentTypes) {
+      LOG_ERROR("Too many component types (more than " << kMaxComponentTypes << "), increase kMaxComponentTypes");
+      std::abort();
+   }
+
+   return id;
+}
+
+} // namespace ComponentTypes
+
 // static
 ComponentRegistry& ComponentRegistry::instance() {
    static ComponentRegistry singleton;
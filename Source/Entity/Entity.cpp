@@ -4,9 +4,16 @@
 
 namespace Shiny {
 
+// static
+const std::uint32_t EntityHandle::kInvalidIndex;
+
 void Entity::destroy() {
    bool destroyed = scene.destroyEntity(this);
    ASSERT(destroyed, "Entity not destroyed by scene, possibly already distroyed?");
 }
 
+void Entity::onSignatureChanged() {
+   scene.updateViews(*this);
+}
+
 } // namespace Shiny
@@ -0,0 +1,160 @@
+#include "Shiny/ShinyAssert.h"
+#include "Shiny/Entity/SystemScheduler.h"
+#include "Shiny/Platform/ThreadPool.h"
+#include "Shiny/Scene/Scene.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+namespace Shiny {
+
+// Per-run state, shared with the pool tasks (which may still be queued after the run completes)
+struct SystemScheduler::RunState {
+   RunState(SystemScheduler& inScheduler, Scene& inScene, float inDt)
+      : scheduler(inScheduler), scene(inScene), dt(inDt), numCompleted(0) {
+   }
+
+   SystemScheduler& scheduler;
+   Scene& scene;
+   const float dt;
+
+   std::mutex mutex;
+   std::condition_variable condition;
+   std::vector<std::size_t> readySystems;
+   std::vector<std::size_t> remainingDependencies;
+   std::size_t numCompleted;
+};
+
+void SystemScheduler::addSystem(UPtr<System> system) {
+   ASSERT(system);
+
+   SystemNode node;
+   node.system = std::move(system);
+   nodes.push_back(std::move(node));
+
+   graphDirty = true;
+}
+
+bool SystemScheduler::removeSystem(System* system) {
+   auto itr = std::find_if(nodes.begin(), nodes.end(), [system](const SystemNode& node) { return node.system.get() == system; });
+   if (itr == nodes.end()) {
+      return false;
+   }
+
+   nodes.erase(itr);
+   graphDirty = true;
+
+   return true;
+}
+
+void SystemScheduler::buildGraph() {
+   for (SystemNode& node : nodes) {
+      node.dependents.clear();
+      node.numDependencies = 0;
+   }
+
+   // Each system depends on every earlier system it conflicts with, which keeps conflicting systems in insertion order
+   for (std::size_t i = 0; i < nodes.size(); ++i) {
+      for (std::size_t j = 0; j < i; ++j) {
+         if (nodes[i].system->conflictsWith(*nodes[j].system)) {
+            nodes[j].dependents.push_back(i);
+            ++nodes[i].numDependencies;
+         }
+      }
+   }
+
+   graphDirty = false;
+}
+
+// static
+bool SystemScheduler::runReadySystem(const std::weak_ptr<RunState>& weakState) {
+   std::shared_ptr<RunState> state = weakState.lock();
+   if (!state) {
+      return false;
+   }
+
+   std::size_t index = 0;
+   {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      if (state->readySystems.empty()) {
+         return false;
+      }
+
+      index = state->readySystems.back();
+      state->readySystems.pop_back();
+   }
+
+   std::vector<SystemNode>& nodes = state->scheduler.nodes;
+   ThreadPool& threadPool = state->scheduler.threadPool;
+
+   nodes[index].system->update(state->scene, state->dt, threadPool);
+
+   std::size_t numNewlyReady = 0;
+   {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      for (std::size_t dependent : nodes[index].dependents) {
+         if (--state->remainingDependencies[dependent] == 0) {
+            state->readySystems.push_back(dependent);
+            ++numNewlyReady;
+         }
+      }
+      ++state->numCompleted;
+   }
+   state->condition.notify_all();
+
+   // The current thread keeps going with one of the newly ready systems, the rest are handed to the pool
+   for (std::size_t i = 1; i < numNewlyReady; ++i) {
+      threadPool.enqueue([weakState]() {
+         while (runReadySystem(weakState)) {
+         }
+      });
+   }
+
+   return true;
+}
+
+void SystemScheduler::run(Scene& scene, float dt) {
+   if (graphDirty) {
+      buildGraph();
+   }
+
+   std::shared_ptr<RunState> state = std::make_shared<RunState>(*this, scene, dt);
+   state->readySystems.reserve(nodes.size());
+   state->remainingDependencies.reserve(nodes.size());
+   for (std::size_t i = 0; i < nodes.size(); ++i) {
+      state->remainingDependencies.push_back(nodes[i].numDependencies);
+      if (nodes[i].numDependencies == 0) {
+         state->readySystems.push_back(i);
+      }
+   }
+
+   // Read before enqueueing, since the workers modify the ready list (under the lock) as soon as they start
+   std::size_t numInitiallyReady = state->readySystems.size();
+
+   std::weak_ptr<RunState> weakState = state;
+   for (std::size_t i = 1; i < numInitiallyReady; ++i) {
+      threadPool.enqueue([weakState]() {
+         while (runReadySystem(weakState)) {
+         }
+      });
+   }
+
+   // The calling thread works through ready systems too, and only sleeps while every ready system is taken
+   std::unique_lock<std::mutex> lock(state->mutex);
+   while (state->numCompleted < nodes.size()) {
+      if (!state->readySystems.empty()) {
+         lock.unlock();
+         runReadySystem(weakState);
+         lock.lock();
+      } else {
+         state->condition.wait(lock);
+      }
+   }
+   lock.unlock();
+
+   scene.flushCommands();
+}
+
+} // namespace Shiny
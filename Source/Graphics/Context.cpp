@@ -1,5 +1,6 @@
 #include "Shiny/Graphics/Context.h"
 
+#include <algorithm>
 #include <array>
 
 namespace Shiny {
@@ -34,8 +35,98 @@ std::size_t textureTargetIndex(Tex::Target textureTarget) {
    }
 }
 
+// Binding queries, in the order of textureTargetIndex()
+const std::array<GLenum, 10> kTextureBindings = {
+   GL_TEXTURE_BINDING_1D,
+   GL_TEXTURE_BINDING_BUFFER,
+   GL_TEXTURE_BINDING_2D,
+   GL_TEXTURE_BINDING_1D_ARRAY,
+   GL_TEXTURE_BINDING_RECTANGLE,
+   GL_TEXTURE_BINDING_2D_MULTISAMPLE,
+   GL_TEXTURE_BINDING_CUBE_MAP,
+   GL_TEXTURE_BINDING_3D,
+   GL_TEXTURE_BINDING_2D_ARRAY,
+   GL_TEXTURE_BINDING_2D_MULTISAMPLE_ARRAY
+};
+
+std::size_t bufferTargetIndex(GLenum bufferTarget) {
+   switch (bufferTarget) {
+   case GL_ARRAY_BUFFER:
+      return 0;
+   case GL_ELEMENT_ARRAY_BUFFER:
+      return 1;
+   case GL_UNIFORM_BUFFER:
+      return 2;
+   case GL_TEXTURE_BUFFER:
+      return 3;
+   default:
+      ASSERT(false, "Invalid buffer target: %u", bufferTarget);
+      return 0;
+   }
+}
+
+// Binding queries, in the order of bufferTargetIndex() (GL_TEXTURE_BUFFER is queried by the target itself)
+const std::array<GLenum, 4> kBufferBindings = {
+   GL_ARRAY_BUFFER_BINDING,
+   GL_ELEMENT_ARRAY_BUFFER_BINDING,
+   GL_UNIFORM_BUFFER_BINDING,
+   GL_TEXTURE_BUFFER
+};
+
+std::size_t capabilityIndex(GLenum capability) {
+   switch (capability) {
+   case GL_BLEND:
+      return 0;
+   case GL_CULL_FACE:
+      return 1;
+   case GL_DEPTH_TEST:
+      return 2;
+   case GL_SCISSOR_TEST:
+      return 3;
+   default:
+      ASSERT(false, "Invalid capability: %u", capability);
+      return 0;
+   }
+}
+
+// In the order of capabilityIndex()
+const std::array<GLenum, 4> kCapabilities = {
+   GL_BLEND,
+   GL_CULL_FACE,
+   GL_DEPTH_TEST,
+   GL_SCISSOR_TEST
+};
+
+GLint getInteger(GLenum name) {
+   GLint value = 0;
+   glGetIntegerv(name, &value);
+   return value;
+}
+
+GLuint getName(GLenum name) {
+   return static_cast<GLuint>(getInteger(name));
+}
+
 } // namespace
 
+// static
+const GLuint Context::kMaxTextureUnits;
+
+// static
+const std::size_t Context::kFrameStatsHistorySize;
+
+// static
+const std::size_t Context::kNumTextureTargets;
+
+// static
+const std::size_t Context::kNumBufferTargets;
+
+// static
+const std::size_t Context::kNumCapabilities;
+
+// static
+const GLuint Context::kUnknownBinding;
+
 // static
 Context* Context::currentContext = nullptr;
 
@@ -51,18 +142,54 @@ void Context::onDestroy(Context *context) {
    }
 }
 
+// Initial values match the GL defaults
 Context::Context()
-   : currentProgram(0), boundVAO(0), boundDrawFBO(0), boundReadFBO(0), boundTextures{}, maxTextureSize(0) {
+   : currentProgram(0), boundVAO(0), boundDrawFBO(0), boundReadFBO(0), numTextureUnits(kMaxTextureUnits),
+     activeTextureUnit(0), boundTextures{}, boundSamplers{}, boundBuffers{}, enabledCapabilities{}, depthFunc(GL_LESS),
+     depthMask(true), blendSourceFactor(GL_ONE), blendDestinationFactor(GL_ZERO), cullFace(GL_BACK), maxTextureSize(0),
+     uniformBufferOffsetAlignment(256), frameStatsHistoryIndex(0), numFrameStatsHistory(0) {
+#if SHINY_DEBUG
+   validationEnabled = false;
+#endif // SHINY_DEBUG
 }
 
 void Context::poll() {
-   glGetIntegerv(GL_CURRENT_PROGRAM, reinterpret_cast<GLint*>(&currentProgram));
-   glGetIntegerv(GL_VERTEX_ARRAY_BINDING, reinterpret_cast<GLint*>(&boundVAO));
-   glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, reinterpret_cast<GLint*>(&boundDrawFBO));
-   glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, reinterpret_cast<GLint*>(&boundReadFBO));
+   currentProgram = getName(GL_CURRENT_PROGRAM);
+   boundVAO = getName(GL_VERTEX_ARRAY_BINDING);
+   boundDrawFBO = getName(GL_DRAW_FRAMEBUFFER_BINDING);
+   boundReadFBO = getName(GL_READ_FRAMEBUFFER_BINDING);
+
+   // Bindings of other units can only be queried by making them active
+   numTextureUnits = std::min(getInteger(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS), static_cast<GLint>(kMaxTextureUnits));
+   activeTextureUnit = getInteger(GL_ACTIVE_TEXTURE) - GL_TEXTURE0;
+   for (GLint unit = 0; unit < numTextureUnits; ++unit) {
+      glActiveTexture(GL_TEXTURE0 + unit);
+
+      for (std::size_t i = 0; i < kNumTextureTargets; ++i) {
+         boundTextures[unit][i] = getName(kTextureBindings[i]);
+      }
+      boundSamplers[unit] = getName(GL_SAMPLER_BINDING);
+   }
+   glActiveTexture(GL_TEXTURE0 + activeTextureUnit);
+
+   for (std::size_t i = 0; i < kNumBufferTargets; ++i) {
+      boundBuffers[i] = getName(kBufferBindings[i]);
+   }
+
+   for (std::size_t i = 0; i < kNumCapabilities; ++i) {
+      enabledCapabilities[i] = glIsEnabled(kCapabilities[i]) == GL_TRUE;
+   }
+
+   depthFunc = getName(GL_DEPTH_FUNC);
+   depthMask = getInteger(GL_DEPTH_WRITEMASK) == GL_TRUE;
+   blendSourceFactor = getName(GL_BLEND_SRC_RGB);
+   blendDestinationFactor = getName(GL_BLEND_DST_RGB);
+   cullFace = getName(GL_CULL_FACE_MODE);
+   glGetIntegerv(GL_SCISSOR_BOX, scissor.data());
 
    glGetIntegerv(GL_VIEWPORT, viewport.data());
    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+   glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformBufferOffsetAlignment);
 }
 
 void Context::onFramebufferSizeChange(int width, int height) {
@@ -78,6 +205,7 @@ void Context::useProgram(GLuint program) {
    if (program != currentProgram) {
       glUseProgram(program);
       currentProgram = program;
+      ++frameStats.programSwitches;
    }
 }
 
@@ -85,22 +213,31 @@ void Context::bindVertexArray(GLuint vao) {
    if (vao != boundVAO) {
       glBindVertexArray(vao);
       boundVAO = vao;
+      ++frameStats.vertexArrayBinds;
+
+      boundBuffers[bufferTargetIndex(GL_ELEMENT_ARRAY_BUFFER)] = kUnknownBinding;
    }
 }
 
-void Context::bindTexture(Tex::Target target, GLuint texture) {
-   std::size_t index = textureTargetIndex(target);
+void Context::bindFramebuffer(GLuint fbo) {
+   if (fbo != boundDrawFBO || fbo != boundReadFBO) {
+      bool drawChanged = fbo != boundDrawFBO;
 
-   if (boundTextures[index] != texture) {
-      glBindTexture(static_cast<GLenum>(target), texture);
-      boundTextures[index] = texture;
+      glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+      boundDrawFBO = boundReadFBO = fbo;
+      ++frameStats.framebufferBinds;
+
+      if (drawChanged && boundDrawFBO == 0) {
+         glViewport(viewport.x, viewport.y, viewport.width, viewport.height);
+      }
    }
 }
 
-void Context::bindFramebuffer(GLuint fbo) {
+void Context::bindDrawFramebuffer(GLuint fbo) {
    if (fbo != boundDrawFBO) {
-      glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-      boundDrawFBO = boundReadFBO = fbo;
+      glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+      boundDrawFBO = fbo;
+      ++frameStats.framebufferBinds;
 
       if (boundDrawFBO == 0) {
          glViewport(viewport.x, viewport.y, viewport.width, viewport.height);
@@ -108,10 +245,244 @@ void Context::bindFramebuffer(GLuint fbo) {
    }
 }
 
+void Context::bindReadFramebuffer(GLuint fbo) {
+   if (fbo != boundReadFBO) {
+      glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+      boundReadFBO = fbo;
+      ++frameStats.framebufferBinds;
+   }
+}
+
+void Context::activeTexture(GLint unit) {
+   ASSERT(unit >= 0 && unit < numTextureUnits, "Invalid texture unit: %d", unit);
+
+   if (unit != activeTextureUnit) {
+      glActiveTexture(GL_TEXTURE0 + unit);
+      activeTextureUnit = unit;
+   }
+}
+
+void Context::bindTexture(Tex::Target target, GLuint texture) {
+   GLuint& boundTexture = boundTextures[activeTextureUnit][textureTargetIndex(target)];
+
+   if (boundTexture != texture) {
+      glBindTexture(static_cast<GLenum>(target), texture);
+      boundTexture = texture;
+      ++frameStats.textureBinds;
+   }
+}
+
+void Context::bindSampler(GLint unit, GLuint sampler) {
+   ASSERT(unit >= 0 && unit < numTextureUnits, "Invalid texture unit: %d", unit);
+
+   if (boundSamplers[unit] != sampler) {
+      glBindSampler(unit, sampler);
+      boundSamplers[unit] = sampler;
+   }
+}
+
+void Context::bindBuffer(GLenum target, GLuint buffer) {
+   GLuint& boundBuffer = boundBuffers[bufferTargetIndex(target)];
+
+   if (boundBuffer != buffer) {
+      glBindBuffer(target, buffer);
+      boundBuffer = buffer;
+   }
+}
+
+void Context::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+   glBindBufferBase(target, index, buffer);
+   boundBuffers[bufferTargetIndex(target)] = buffer;
+}
+
+void Context::bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+   glBindBufferRange(target, index, buffer, offset, size);
+   boundBuffers[bufferTargetIndex(target)] = buffer;
+}
+
+void Context::setEnabled(GLenum capability, bool enabled) {
+   bool& capabilityEnabled = enabledCapabilities[capabilityIndex(capability)];
+
+   if (capabilityEnabled != enabled) {
+      if (enabled) {
+         glEnable(capability);
+      } else {
+         glDisable(capability);
+      }
+      capabilityEnabled = enabled;
+   }
+}
+
+bool Context::isEnabled(GLenum capability) const {
+   return enabledCapabilities[capabilityIndex(capability)];
+}
+
+void Context::setDepthFunc(GLenum func) {
+   if (func != depthFunc) {
+      glDepthFunc(func);
+      depthFunc = func;
+   }
+}
+
+void Context::setDepthMask(bool mask) {
+   if (mask != depthMask) {
+      glDepthMask(mask ? GL_TRUE : GL_FALSE);
+      depthMask = mask;
+   }
+}
+
+void Context::setBlendFunc(GLenum sourceFactor, GLenum destinationFactor) {
+   if (sourceFactor != blendSourceFactor || destinationFactor != blendDestinationFactor) {
+      glBlendFunc(sourceFactor, destinationFactor);
+      blendSourceFactor = sourceFactor;
+      blendDestinationFactor = destinationFactor;
+   }
+}
+
+void Context::setCullFace(GLenum face) {
+   if (face != cullFace) {
+      glCullFace(face);
+      cullFace = face;
+   }
+}
+
+void Context::setScissor(const Viewport& box) {
+   if (box.x != scissor.x || box.y != scissor.y || box.width != scissor.width || box.height != scissor.height) {
+      glScissor(box.x, box.y, box.width, box.height);
+      scissor = box;
+   }
+}
+
 void Context::onFramebufferDeleted(GLuint fbo) {
    if (fbo == boundDrawFBO) {
-      bindFramebuffer(0);
+      bindDrawFramebuffer(0);
+   }
+
+   if (fbo == boundReadFBO) {
+      bindReadFramebuffer(0);
+   }
+}
+
+void Context::onVertexArrayDeleted(GLuint vao) {
+   if (vao != 0 && vao == boundVAO) {
+      boundVAO = 0;
+      boundBuffers[bufferTargetIndex(GL_ELEMENT_ARRAY_BUFFER)] = kUnknownBinding;
+   }
+}
+
+void Context::onTextureDeleted(GLuint texture) {
+   if (texture == 0) {
+      return;
+   }
+
+   for (GLint unit = 0; unit < numTextureUnits; ++unit) {
+      for (GLuint& boundTexture : boundTextures[unit]) {
+         if (boundTexture == texture) {
+            boundTexture = 0;
+         }
+      }
    }
 }
 
+void Context::onSamplerDeleted(GLuint sampler) {
+   if (sampler == 0) {
+      return;
+   }
+
+   for (GLuint& boundSampler : boundSamplers) {
+      if (boundSampler == sampler) {
+         boundSampler = 0;
+      }
+   }
+}
+
+void Context::onBufferDeleted(GLuint buffer) {
+   if (buffer == 0) {
+      return;
+   }
+
+   for (GLuint& boundBuffer : boundBuffers) {
+      if (boundBuffer == buffer) {
+         boundBuffer = 0;
+      }
+   }
+}
+
+#if SHINY_DEBUG
+void Context::validate() {
+   ASSERT(getName(GL_CURRENT_PROGRAM) == currentProgram, "Cached program (%u) is out of date", currentProgram);
+   ASSERT(getName(GL_VERTEX_ARRAY_BINDING) == boundVAO, "Cached VAO (%u) is out of date", boundVAO);
+   ASSERT(getName(GL_DRAW_FRAMEBUFFER_BINDING) == boundDrawFBO, "Cached draw FBO (%u) is out of date", boundDrawFBO);
+   ASSERT(getName(GL_READ_FRAMEBUFFER_BINDING) == boundReadFBO, "Cached read FBO (%u) is out of date", boundReadFBO);
+
+   ASSERT(getInteger(GL_ACTIVE_TEXTURE) - GL_TEXTURE0 == activeTextureUnit, "Cached active texture unit (%d) is out of date", activeTextureUnit);
+   for (GLint unit = 0; unit < numTextureUnits; ++unit) {
+      glActiveTexture(GL_TEXTURE0 + unit);
+
+      for (std::size_t i = 0; i < kNumTextureTargets; ++i) {
+         ASSERT(getName(kTextureBindings[i]) == boundTextures[unit][i], "Cached texture binding (%u) of unit %d is out of date", boundTextures[unit][i], unit);
+      }
+      ASSERT(getName(GL_SAMPLER_BINDING) == boundSamplers[unit], "Cached sampler binding (%u) of unit %d is out of date", boundSamplers[unit], unit);
+   }
+   glActiveTexture(GL_TEXTURE0 + activeTextureUnit);
+
+   for (std::size_t i = 0; i < kNumBufferTargets; ++i) {
+      if (boundBuffers[i] != kUnknownBinding) {
+         ASSERT(getName(kBufferBindings[i]) == boundBuffers[i], "Cached buffer binding (%u) is out of date", boundBuffers[i]);
+      }
+   }
+
+   for (std::size_t i = 0; i < kNumCapabilities; ++i) {
+      ASSERT((glIsEnabled(kCapabilities[i]) == GL_TRUE) == enabledCapabilities[i], "Cached capability (%u) is out of date", kCapabilities[i]);
+   }
+
+   ASSERT(getName(GL_DEPTH_FUNC) == depthFunc, "Cached depth func (%u) is out of date", depthFunc);
+   ASSERT((getInteger(GL_DEPTH_WRITEMASK) == GL_TRUE) == depthMask, "Cached depth mask (%d) is out of date", depthMask);
+   ASSERT(getName(GL_BLEND_SRC_RGB) == blendSourceFactor && getName(GL_BLEND_SRC_ALPHA) == blendSourceFactor, "Cached blend source factor (%u) is out of date", blendSourceFactor);
+   ASSERT(getName(GL_BLEND_DST_RGB) == blendDestinationFactor && getName(GL_BLEND_DST_ALPHA) == blendDestinationFactor, "Cached blend destination factor (%u) is out of date", blendDestinationFactor);
+   ASSERT(getName(GL_CULL_FACE_MODE) == cullFace, "Cached cull face (%u) is out of date", cullFace);
+
+   Viewport actualScissor;
+   glGetIntegerv(GL_SCISSOR_BOX, actualScissor.data());
+   ASSERT(actualScissor.x == scissor.x && actualScissor.y == scissor.y && actualScissor.width == scissor.width && actualScissor.height == scissor.height, "Cached scissor box is out of date");
+}
+#endif // SHINY_DEBUG
+
+void Context::endFrame() {
+#if SHINY_GPU_PROFILING
+   gpuProfiler.endFrame();
+#endif // SHINY_GPU_PROFILING
+
+   lastFrameStats = frameStats;
+   frameStats = FrameStats();
+
+   frameStatsHistory[frameStatsHistoryIndex] = lastFrameStats;
+   frameStatsHistoryIndex = (frameStatsHistoryIndex + 1) % kFrameStatsHistorySize;
+   numFrameStatsHistory = std::min(numFrameStatsHistory + 1, kFrameStatsHistorySize);
+
+   if (frameStatsHook) {
+      frameStatsHook(lastFrameStats, getAverageFrameStats());
+   }
+}
+
+AverageFrameStats Context::getAverageFrameStats() const {
+   AverageFrameStats averageFrameStats;
+   if (numFrameStatsHistory == 0) {
+      return averageFrameStats;
+   }
+
+   // The history is only partially filled until kFrameStatsHistorySize frames have ended, from index 0 up
+   for (std::size_t i = 0; i < numFrameStatsHistory; ++i) {
+#define SHINY_SUM_FRAME_STATS_COUNTER(name, label) averageFrameStats.name += static_cast<double>(frameStatsHistory[i].name);
+      SHINY_FRAME_STATS_COUNTERS(SHINY_SUM_FRAME_STATS_COUNTER)
+#undef SHINY_SUM_FRAME_STATS_COUNTER
+   }
+
+#define SHINY_AVERAGE_FRAME_STATS_COUNTER(name, label) averageFrameStats.name /= static_cast<double>(numFrameStatsHistory);
+   SHINY_FRAME_STATS_COUNTERS(SHINY_AVERAGE_FRAME_STATS_COUNTER)
+#undef SHINY_AVERAGE_FRAME_STATS_COUNTER
+
+   return averageFrameStats;
+}
+
 } // namespace Shiny
@@ -0,0 +1,25 @@
+#include "Shiny/Graphics/FrameStats.h"
+
+#include <iomanip>
+#include <sstream>
+
+namespace Shiny {
+
+template<typename T>
+std::string BasicFrameStats<T>::toString() const {
+   std::stringstream ss;
+
+   // Only affects averages
+   ss << std::fixed << std::setprecision(1);
+
+   forEach([&ss](const char* label, T value) {
+      ss << label << ": " << value << "\n";
+   });
+
+   return ss.str();
+}
+
+template struct BasicFrameStats<std::uint64_t>;
+template struct BasicFrameStats<double>;
+
+} // namespace Shiny
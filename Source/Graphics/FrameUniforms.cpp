@@ -0,0 +1,35 @@
+#include "Shiny/ShinyAssert.h"
+#include "Shiny/Graphics/Context.h"
+#include "Shiny/Graphics/FrameUniforms.h"
+
+#include <algorithm>
+
+namespace Shiny {
+
+FrameUniformBuffer::FrameUniformBuffer()
+   : id(0) {
+   glGenBuffers(1, &id);
+
+   Context::current()->bindBuffer(GL_UNIFORM_BUFFER, id);
+   glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniformData), nullptr, GL_DYNAMIC_DRAW);
+}
+
+FrameUniformBuffer::~FrameUniformBuffer() {
+   Context::current()->onBufferDeleted(id);
+   glDeleteBuffers(1, &id);
+}
+
+void FrameUniformBuffer::upload(const FrameUniformData& data) {
+   ASSERT(data.numLights.x >= 0 && data.numLights.x <= FrameUniforms::kMaxLights, "Invalid number of lights: %d", data.numLights.x);
+
+   std::size_t numLights = static_cast<std::size_t>(std::max(data.numLights.x, 0));
+   std::size_t size = offsetof(FrameUniformData, lights) + numLights * sizeof(FrameUniformData::Light);
+
+   Context* context = Context::current();
+   context->bindBuffer(GL_UNIFORM_BUFFER, id);
+   glBufferSubData(GL_UNIFORM_BUFFER, 0, size, &data);
+   context->onBufferUpload(size);
+   context->bindBufferBase(GL_UNIFORM_BUFFER, FrameUniforms::kBindingPoint, id);
+}
+
+} // namespace Shiny
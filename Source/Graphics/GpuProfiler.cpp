@@ -0,0 +1,189 @@
+#include "Shiny/ShinyAssert.h"
+#include "Shiny/Graphics/Context.h"
+#include "Shiny/Graphics/GpuProfiler.h"
+
+#if SHINY_GPU_PROFILING
+
+namespace Shiny {
+
+namespace {
+
+const double kNanosecondsPerMillisecond = 1.0e6;
+
+double elapsedMilliseconds(GLuint64 begin, GLuint64 end) {
+   return end > begin ? static_cast<double>(end - begin) / kNanosecondsPerMillisecond : 0.0;
+}
+
+std::size_t findOrAddChild(GpuScopeTiming& parent, const char* name) {
+   for (std::size_t i = 0; i < parent.children.size(); ++i) {
+      if (parent.children[i].name == name) {
+         return i;
+      }
+   }
+
+   parent.children.emplace_back();
+   parent.children.back().name = name;
+   return parent.children.size() - 1;
+}
+
+} // namespace
+
+// static
+const std::size_t GpuProfiler::kFrameLatency;
+
+// static
+const std::size_t GpuProfiler::kNoParent;
+
+GpuProfiler::GpuProfiler()
+   : frameIndex(0), frame(0), started(false), numDroppedFrames(0) {
+}
+
+GpuProfiler::~GpuProfiler() {
+   for (FrameQueries& frameQueries : frames) {
+      if (!frameQueries.queries.empty()) {
+         glDeleteQueries(static_cast<GLsizei>(frameQueries.queries.size()), frameQueries.queries.data());
+      }
+   }
+}
+
+void GpuProfiler::beginScope(const char* name) {
+   ASSERT(name, "Trying to begin GPU scope with null name");
+
+   // Nothing is issued until the first scope, so that an unused profiler costs nothing
+   if (!started) {
+      started = true;
+      beginFrame();
+   }
+
+   FrameQueries& frameQueries = frames[frameIndex];
+
+   ScopeRecord record;
+   record.name = name;
+   record.parent = scopeStack.empty() ? kNoParent : scopeStack.back();
+   record.beginQuery = issueTimestamp(frameQueries);
+   record.endQuery = record.beginQuery;
+
+   scopeStack.push_back(frameQueries.scopes.size());
+   frameQueries.scopes.push_back(record);
+}
+
+void GpuProfiler::endScope() {
+   ASSERT(!scopeStack.empty(), "Trying to end GPU scope that wasn't begun");
+
+   FrameQueries& frameQueries = frames[frameIndex];
+   frameQueries.scopes[scopeStack.back()].endQuery = issueTimestamp(frameQueries);
+   scopeStack.pop_back();
+}
+
+void GpuProfiler::endFrame() {
+   if (!started) {
+      return;
+   }
+   ASSERT(scopeStack.empty(), "GPU scopes still open at the end of the frame: %lu", scopeStack.size());
+
+   // The frame ends at its last query
+   FrameQueries& currentFrameQueries = frames[frameIndex];
+   issueTimestamp(currentFrameQueries);
+   currentFrameQueries.pending = true;
+
+   // Oldest first (queries complete in order, so once a frame isn't available, newer ones aren't either)
+   for (std::size_t i = 1; i <= kFrameLatency; ++i) {
+      FrameQueries& frameQueries = frames[(frameIndex + i) % kFrameLatency];
+      if (frameQueries.pending && !tryResolve(frameQueries)) {
+         break;
+      }
+   }
+
+   frameIndex = (frameIndex + 1) % kFrameLatency;
+   ++frame;
+   beginFrame();
+}
+
+std::size_t GpuProfiler::issueTimestamp(FrameQueries& frameQueries) {
+   if (frameQueries.numUsedQueries == frameQueries.queries.size()) {
+      GLuint query = 0;
+      glGenQueries(1, &query);
+      frameQueries.queries.push_back(query);
+   }
+
+   std::size_t index = frameQueries.numUsedQueries++;
+   glQueryCounter(frameQueries.queries[index], GL_TIMESTAMP);
+
+   return index;
+}
+
+void GpuProfiler::beginFrame() {
+   FrameQueries& frameQueries = frames[frameIndex];
+
+   // Still not available after kFrameLatency frames - waiting for the results would stall, so they are dropped instead
+   if (frameQueries.pending) {
+      ++numDroppedFrames;
+   }
+
+   frameQueries.numUsedQueries = 0;
+   frameQueries.scopes.clear();
+   frameQueries.frame = frame;
+   frameQueries.pending = false;
+
+   issueTimestamp(frameQueries);
+}
+
+bool GpuProfiler::tryResolve(FrameQueries& frameQueries) {
+   ASSERT(frameQueries.numUsedQueries >= 2, "Pending frame without start / end queries");
+
+   GLint available = GL_FALSE;
+   glGetQueryObjectiv(frameQueries.queries[frameQueries.numUsedQueries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+   if (!available) {
+      return false;
+   }
+
+   std::vector<GLuint64> timestamps(frameQueries.numUsedQueries);
+   for (std::size_t i = 0; i < timestamps.size(); ++i) {
+      glGetQueryObjectui64v(frameQueries.queries[i], GL_QUERY_RESULT, &timestamps[i]);
+   }
+
+   profile.frame = frameQueries.frame;
+   profile.root = GpuScopeTiming();
+   profile.root.name = "Frame";
+   profile.root.milliseconds = elapsedMilliseconds(timestamps.front(), timestamps.back());
+   profile.root.count = 1;
+
+   // Scopes are recorded before their children, so parents always have a node already. Nodes are found by their path
+   // from the root, since adding a child can move its siblings.
+   std::vector<std::vector<std::size_t>> nodePaths(frameQueries.scopes.size());
+   for (std::size_t i = 0; i < frameQueries.scopes.size(); ++i) {
+      const ScopeRecord& scope = frameQueries.scopes[i];
+      std::vector<std::size_t>& path = nodePaths[i];
+
+      GpuScopeTiming* parentNode = &profile.root;
+      if (scope.parent != kNoParent) {
+         path = nodePaths[scope.parent];
+         for (std::size_t childIndex : path) {
+            parentNode = &parentNode->children[childIndex];
+         }
+      }
+
+      std::size_t childIndex = findOrAddChild(*parentNode, scope.name);
+      path.push_back(childIndex);
+
+      GpuScopeTiming& node = parentNode->children[childIndex];
+      node.milliseconds += elapsedMilliseconds(timestamps[scope.beginQuery], timestamps[scope.endQuery]);
+      ++node.count;
+   }
+
+   frameQueries.pending = false;
+   return true;
+}
+
+GpuScope::GpuScope(const char* name)
+   : profiler(Context::current()->getGpuProfiler()) {
+   profiler.beginScope(name);
+}
+
+GpuScope::~GpuScope() {
+   profiler.endScope();
+}
+
+} // namespace Shiny
+
+#endif // SHINY_GPU_PROFILING
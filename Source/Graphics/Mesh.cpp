@@ -4,6 +4,9 @@
 #include "Shiny/Graphics/Mesh.h"
 #include "Shiny/Graphics/ShaderProgram.h"
 
+#include <algorithm>
+#include <cstddef>
+
 namespace Shiny {
 
 namespace {
@@ -28,8 +31,9 @@ void prepareBuffer(GLuint *buffer, GLenum target, unsigned int numValues, unsign
 
    size_t valueSize = target == GL_ELEMENT_ARRAY_BUFFER ? sizeof(unsigned int) : sizeof(float);
 
-   glBindBuffer(target, *buffer);
+   Context::current()->bindBuffer(target, *buffer);
    glBufferData(target, numValues * dimensionality * valueSize, data, usage);
+   Context::current()->onBufferUpload(numValues * dimensionality * valueSize);
 
    if (target == GL_ARRAY_BUFFER) {
       glEnableVertexAttribArray(atrributes);
@@ -37,6 +41,18 @@ void prepareBuffer(GLuint *buffer, GLenum target, unsigned int numValues, unsign
    }
 }
 
+void prepareInstanceMatrixAttribute(GLint attribute, std::size_t offset) {
+   // Matrix attributes take one location per column
+   for (GLint column = 0; column < 4; ++column) {
+      GLuint location = static_cast<GLuint>(attribute + column);
+      std::size_t columnOffset = offset + column * sizeof(glm::vec4);
+
+      glEnableVertexAttribArray(location);
+      glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(Mesh::InstanceData), reinterpret_cast<const void*>(columnOffset));
+      glVertexAttribDivisor(location, 1);
+   }
+}
+
 } // namespace
 
 Mesh::Mesh()
@@ -71,10 +87,19 @@ Mesh::~Mesh() {
 }
 
 void Mesh::release() {
+   if (vao != 0) {
+      Context* context = Context::current();
+      for (GLuint buffer : { vbo, nbo, tbo, ibo, instanceBuffer }) {
+         context->onBufferDeleted(buffer);
+      }
+      context->onVertexArrayDeleted(vao);
+   }
+
    glDeleteBuffers(1, &vbo);
    glDeleteBuffers(1, &nbo);
    glDeleteBuffers(1, &tbo);
    glDeleteBuffers(1, &ibo);
+   glDeleteBuffers(1, &instanceBuffer);
    glDeleteVertexArrays(1, &vao);
 }
 
@@ -84,14 +109,22 @@ void Mesh::move(Mesh &&other) {
    tbo = other.tbo;
    ibo = other.ibo;
    vao = other.vao;
+   instanceBuffer = other.instanceBuffer;
    numIndices = other.numIndices;
+   instanceBufferCapacity = other.instanceBufferCapacity;
+   boundingBox = other.boundingBox;
+   boundingSphere = other.boundingSphere;
+   hasBounds = other.hasBounds;
 
    other.vbo = 0;
    other.nbo = 0;
    other.tbo = 0;
    other.ibo = 0;
    other.vao = 0;
+   other.instanceBuffer = 0;
    other.numIndices = 0;
+   other.instanceBufferCapacity = 0;
+   other.hasBounds = false;
 }
 
 void Mesh::bindVAO() const {
@@ -102,6 +135,39 @@ void Mesh::bindVAO() const {
 void Mesh::draw() const {
    bindVAO();
    glDrawElements(GL_TRIANGLES, numIndices, GL_UNSIGNED_INT, 0);
+   Context::current()->onDraw(1);
+}
+
+void Mesh::drawInstanced(unsigned int numInstances) const {
+   ASSERT(numInstances <= instanceBufferCapacity, "Drawing more instances than were uploaded: %u", numInstances);
+
+   bindVAO();
+   glDrawElementsInstanced(GL_TRIANGLES, numIndices, GL_UNSIGNED_INT, 0, numInstances);
+   Context::current()->onDraw(numInstances);
+}
+
+void Mesh::setInstanceData(const InstanceData *instances, unsigned int numInstances) {
+   ASSERT(numInstances == 0 || instances, "numInstances > 0, but no data provided");
+
+   bindVAO();
+
+   if (instanceBuffer == 0) {
+      glGenBuffers(1, &instanceBuffer);
+      Context::current()->bindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+
+      prepareInstanceMatrixAttribute(ShaderAttributes::kInstanceModelMatrix, offsetof(InstanceData, modelMatrix));
+      prepareInstanceMatrixAttribute(ShaderAttributes::kInstanceNormalMatrix, offsetof(InstanceData, normalMatrix));
+   } else {
+      Context::current()->bindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+   }
+
+   // Grow geometrically, and orphan the old storage otherwise so that the upload doesn't wait on draws still using it
+   if (numInstances > instanceBufferCapacity) {
+      instanceBufferCapacity = std::max<std::size_t>(numInstances, instanceBufferCapacity * 2);
+   }
+   glBufferData(GL_ARRAY_BUFFER, instanceBufferCapacity * sizeof(InstanceData), nullptr, GL_STREAM_DRAW);
+   glBufferSubData(GL_ARRAY_BUFFER, 0, numInstances * sizeof(InstanceData), instances);
+   Context::current()->onBufferUpload(numInstances * sizeof(InstanceData));
 }
 
 void Mesh::setVertices(const float *vertices, unsigned int numVertices, unsigned int dimensionality, GLenum usage) {
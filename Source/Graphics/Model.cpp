@@ -26,25 +26,38 @@ Model& Model::operator=(Model &&other) {
 void Model::move(Model &&other) {
    mesh = std::move(other.mesh);
    program = std::move(other.program);
+   gBufferProgram = std::move(other.gBufferProgram);
    materials = std::move(other.materials);
 }
 
 void Model::draw(RenderData renderData) {
-   ShaderProgram* overrideProgram = renderData.getOverrideProgram();
-   ShaderProgram* activeProgram = overrideProgram ? overrideProgram : program.get();
+   if (prepareDraw(renderData)) {
+      mesh->draw();
+   }
+}
 
-   if (mesh && activeProgram) {
-      mesh->bindVAO();
+void Model::drawInstanced(RenderData renderData, unsigned int numInstances) {
+   if (prepareDraw(renderData)) {
+      mesh->drawInstanced(numInstances);
+   }
+}
 
-      if (!overrideProgram) {
-         for (const SPtr<Material>& material : materials) {
-            material->apply(*activeProgram, renderData);
-         }
-      }
+bool Model::prepareDraw(RenderData& renderData) {
+   ShaderProgram* activeProgram = selectShaderProgram(renderData);
+   if (!mesh || !activeProgram) {
+      return false;
+   }
 
-      activeProgram->commit();
-      mesh->draw();
+   mesh->bindVAO();
+
+   if (!renderData.getOverrideProgram()) {
+      for (const SPtr<Material>& material : materials) {
+         material->apply(*activeProgram, renderData);
+      }
    }
+
+   activeProgram->commit();
+   return true;
 }
 
 void Model::setMesh(const SPtr<Mesh> &mesh) {
@@ -55,6 +68,10 @@ void Model::setShaderProgram(const SPtr<ShaderProgram> &program) {
    this->program = program;
 }
 
+void Model::setGBufferShaderProgram(const SPtr<ShaderProgram> &program) {
+   gBufferProgram = program;
+}
+
 void Model::attachMaterial(const SPtr<Material> &material) {
    materials.push_back(material);
 }
@@ -2,6 +2,7 @@
 #include "Shiny/ShinyAssert.h"
 
 #include "Shiny/Graphics/Context.h"
+#include "Shiny/Graphics/FrameUniforms.h"
 #include "Shiny/Graphics/Shader.h"
 #include "Shiny/Graphics/ShaderProgram.h"
 #include "Shiny/Graphics/UniformTypes.h"
@@ -134,7 +135,14 @@ std::vector<std::string> getUniformNames(const char* nameBuf, GLsizei length, GL
    return names;
 }
 
-void createProgramUniformsAtIndex(UniformMap& uniformMap, GLuint program, GLuint index) {
+void createProgramUniformsAtIndex(std::vector<UPtr<Uniform>>& newUniforms, GLuint program, GLuint index) {
+   // Members of uniform blocks are backed by buffers, not set per program
+   GLint blockIndex = -1;
+   glGetActiveUniformsiv(program, 1, &index, GL_UNIFORM_BLOCK_INDEX, &blockIndex);
+   if (blockIndex != -1) {
+      return;
+   }
+
    std::array<GLchar, 256> nameBuf;
    GLsizei length = 0;
    GLint size = 0;
@@ -151,30 +159,42 @@ void createProgramUniformsAtIndex(UniformMap& uniformMap, GLuint program, GLuint
       GLint location = glGetUniformLocation(program, uniformName.c_str());
       ASSERT(location >= 0);
 
-      uniformMap.emplace(uniformName, createUniform(uniformName, location, type, program));
+      newUniforms.push_back(createUniform(uniformName, location, type, program));
    }
 }
 
-void createProgramUniforms(UniformMap& uniformMap, GLuint program) {
+void createProgramUniforms(std::vector<UPtr<Uniform>>& newUniforms, GLuint program) {
    GLint numUniforms = 0;
    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &numUniforms);
 
    for (GLint i = 0; i < numUniforms; ++i) {
-      createProgramUniformsAtIndex(uniformMap, program, i);
+      createProgramUniformsAtIndex(newUniforms, program, i);
+   }
+}
+
+void bindUniformBlocks(GLuint program) {
+   GLuint frameBlockIndex = glGetUniformBlockIndex(program, FrameUniforms::kBlockName);
+   if (frameBlockIndex != GL_INVALID_INDEX) {
+      glUniformBlockBinding(program, frameBlockIndex, FrameUniforms::kBindingPoint);
+   }
+
+   GLuint drawBlockIndex = glGetUniformBlockIndex(program, DrawUniforms::kBlockName);
+   if (drawBlockIndex != GL_INVALID_INDEX) {
+      glUniformBlockBinding(program, drawBlockIndex, DrawUniforms::kBindingPoint);
    }
 }
 
-void bindAttribute(GLuint program, GLuint attribute) {
-   glBindAttribLocation(program, attribute, ShaderAttributes::kNames[attribute]);
+void bindAttributes(GLuint program) {
+   for (const auto& pair : ShaderAttributes::kNames) {
+      glBindAttribLocation(program, pair.first, pair.second);
+   }
 }
 
 } // namespace
 
 ShaderProgram::ShaderProgram()
-   : id(glCreateProgram()) {
-   for (size_t i = 0; i < ShaderAttributes::kNames.size(); ++i) {
-      bindAttribute(id, static_cast<GLuint>(i));
-   }
+   : id(glCreateProgram()), instanced(false), drawBlock(false) {
+   bindAttributes(id);
 }
 
 ShaderProgram::ShaderProgram(ShaderProgram &&other) {
@@ -200,8 +220,33 @@ void ShaderProgram::move(ShaderProgram &&other) {
    id = other.id;
    shaders = std::move(other.shaders);
    uniforms = std::move(other.uniforms);
+   uniformSlotTypes = std::move(other.uniformSlotTypes);
+   uniformIndices = std::move(other.uniformIndices);
+   dirtyUniforms = std::move(other.dirtyUniforms);
+   instanced = other.instanced;
+   drawBlock = other.drawBlock;
+
+   for (std::size_t i = 0; i < uniforms.size(); ++i) {
+      if (uniforms[i]) {
+         uniforms[i]->setDirtyList(&dirtyUniforms, static_cast<std::uint32_t>(i));
+      }
+   }
+
+   // Handles refer to their program, so they need to be resolved again
+   modelMatrixUniform = getUniform<glm::mat4>(ShaderUniforms::kModelMatrix);
+   normalMatrixUniform = getUniform<glm::mat4>(ShaderUniforms::kNormalMatrix);
 
+   // Moved-from vectors are only guaranteed to be valid, and handles still pointing at the other program check its slot
+   // count, so leave it explicitly empty
    other.id = 0;
+   other.uniforms.clear();
+   other.uniformSlotTypes.clear();
+   other.uniformIndices.clear();
+   other.dirtyUniforms.clear();
+   other.modelMatrixUniform = UniformHandle<glm::mat4>();
+   other.normalMatrixUniform = UniformHandle<glm::mat4>();
+   other.instanced = false;
+   other.drawBlock = false;
 }
 
 void ShaderProgram::attach(const SPtr<Shader>& shader) {
@@ -214,7 +259,15 @@ void ShaderProgram::attach(const SPtr<Shader>& shader) {
 bool ShaderProgram::link() {
    ASSERT(shaders.size() >= 2, "Need at least two shaders to link: %lu", shaders.size());
 
-   uniforms.clear();
+   // Empty the slots (rather than removing them), so that existing handles never refer to the wrong uniform
+   for (UPtr<Uniform>& uniform : uniforms) {
+      uniform.reset();
+   }
+   std::unordered_map<std::string, std::uint32_t> previousIndices = std::move(uniformIndices);
+   uniformIndices.clear();
+   dirtyUniforms.clear();
+   instanced = false;
+   drawBlock = false;
 
    glLinkProgram(id);
 
@@ -225,17 +278,53 @@ bool ShaderProgram::link() {
       return false;
    }
 
-   createProgramUniforms(uniforms, id);
+   std::vector<UPtr<Uniform>> newUniforms;
+   createProgramUniforms(newUniforms, id);
+
+   for (UPtr<Uniform>& newUniform : newUniforms) {
+      // Uniforms keep their previous slot as long as their type is unchanged
+      auto previousItr = previousIndices.find(newUniform->getName());
+      std::uint32_t index = 0;
+      if (previousItr != previousIndices.end() && uniformSlotTypes[previousItr->second] == newUniform->getType()) {
+         index = previousItr->second;
+      } else {
+         index = static_cast<std::uint32_t>(uniforms.size());
+         uniforms.emplace_back();
+         uniformSlotTypes.push_back(newUniform->getType());
+      }
+
+      uniformIndices.emplace(newUniform->getName(), index);
+      newUniform->setDirtyList(&dirtyUniforms, index);
+      uniforms[index] = std::move(newUniform);
+   }
+
+   modelMatrixUniform = getUniform<glm::mat4>(ShaderUniforms::kModelMatrix);
+   normalMatrixUniform = getUniform<glm::mat4>(ShaderUniforms::kNormalMatrix);
+
+   bindUniformBlocks(id);
+
+   // Programs opt in to instancing by reading the per-instance model matrix (see ShaderLoader::kInstancingDefinition)
+   instanced = glGetAttribLocation(id, "aInstanceModelMatrix") == ShaderAttributes::kInstanceModelMatrix;
+   drawBlock = glGetUniformBlockIndex(id, DrawUniforms::kBlockName) != GL_INVALID_INDEX;
 
    return true;
 }
 
 void ShaderProgram::commit() {
-   Context::current()->useProgram(id);
-
-   for (const auto& pair : uniforms) {
-      pair.second->commit();
+   Context* context = Context::current();
+   context->useProgram(id);
+
+   // Only uniforms that changed since the last commit are uploaded (slots can be empty after a relink)
+   std::size_t numUploads = 0;
+   for (std::uint32_t index : dirtyUniforms) {
+      Uniform* uniform = uniforms[index].get();
+      if (uniform && uniform->commit()) {
+         ++numUploads;
+      }
    }
+   dirtyUniforms.clear();
+
+   context->onUniformUploads(numUploads);
 }
 
 } // namespace Shiny
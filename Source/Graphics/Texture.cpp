@@ -258,6 +258,9 @@ Texture::~Texture() {
 }
 
 void Texture::release() {
+   if (id != 0) {
+      Context::current()->onTextureDeleted(id);
+   }
    glDeleteTextures(1, &id);
 }
 
@@ -1,5 +1,6 @@
 #include "Shiny/ShinyAssert.h"
 
+#include "Shiny/Graphics/Context.h"
 #include "Shiny/Graphics/RenderData.h"
 #include "Shiny/Graphics/ShaderProgram.h"
 #include "Shiny/Graphics/Texture.h"
@@ -17,7 +18,7 @@ void TextureMaterial::apply(ShaderProgram& program, RenderData& renderData) {
    }
 
    GLint textureUnit = renderData.aquireTextureUnit();
-   glActiveTexture(GL_TEXTURE0 + textureUnit);
+   Context::current()->activeTexture(textureUnit);
    texture->bind();
 
    program.setUniformValue(uniformName, textureUnit);
@@ -0,0 +1,400 @@
+#include "Shiny/Math/DynamicBvh.h"
+
+#include <queue>
+#include <utility>
+
+namespace Shiny {
+
+namespace {
+
+float surfaceArea(const BoundingBox& box) {
+   glm::vec3 size = box.max - box.min;
+   return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+BoundingBox merge(const BoundingBox& first, const BoundingBox& second) {
+   BoundingBox merged = first;
+   merged.addBox(second);
+   return merged;
+}
+
+bool contains(const BoundingBox& outer, const BoundingBox& inner) {
+   return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z
+      && outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+}
+
+} // namespace
+
+// static
+const DynamicBvh::ProxyId DynamicBvh::kNullProxy;
+
+// static
+const DynamicBvh::NodeIndex DynamicBvh::kNullNode;
+
+// static
+const std::size_t DynamicBvh::kInitialStackCapacity;
+
+DynamicBvh::DynamicBvh(float inMargin)
+   : root(kNullNode), freeList(kNullNode), numProxies(0), numReinsertsSinceRebuild(0), margin(inMargin) {
+}
+
+DynamicBvh::ProxyId DynamicBvh::createProxy(const BoundingBox& box, void* userData) {
+   ASSERT(!box.isEmpty(), "Trying to create proxy with empty bounds");
+
+   NodeIndex leaf = allocateNode();
+   nodes[leaf].box = BoundingBox(box.min - glm::vec3(margin), box.max + glm::vec3(margin));
+   nodes[leaf].userData = userData;
+   nodes[leaf].height = 0;
+
+   insertLeaf(leaf);
+   ++numProxies;
+
+   return leaf;
+}
+
+void DynamicBvh::destroyProxy(ProxyId proxyId) {
+   ASSERT(isValidProxy(proxyId), "Trying to destroy invalid proxy: %d", proxyId);
+
+   removeLeaf(proxyId);
+   freeNode(proxyId);
+   --numProxies;
+}
+
+bool DynamicBvh::moveProxy(ProxyId proxyId, const BoundingBox& box) {
+   ASSERT(isValidProxy(proxyId), "Trying to move invalid proxy: %d", proxyId);
+   ASSERT(!box.isEmpty(), "Trying to move proxy to empty bounds");
+
+   if (contains(nodes[proxyId].box, box)) {
+      return false;
+   }
+
+   removeLeaf(proxyId);
+   nodes[proxyId].box = BoundingBox(box.min - glm::vec3(margin), box.max + glm::vec3(margin));
+   insertLeaf(proxyId);
+
+   ++numReinsertsSinceRebuild;
+   return true;
+}
+
+void DynamicBvh::rebuildIfNeeded() {
+   // Rotations keep the tree balanced, but the quality of the partitioning slowly degrades as leaves are re-inserted
+   if (numReinsertsSinceRebuild > numProxies) {
+      rebuild();
+   }
+}
+
+void DynamicBvh::rebuild() {
+   numReinsertsSinceRebuild = 0;
+
+   std::vector<NodeIndex> leaves;
+   leaves.reserve(numProxies);
+   for (NodeIndex i = 0; i < static_cast<NodeIndex>(nodes.size()); ++i) {
+      if (nodes[i].height < 0) {
+         continue;
+      }
+
+      if (nodes[i].isLeaf()) {
+         nodes[i].parent = kNullNode;
+         leaves.push_back(i);
+      } else {
+         freeNode(i);
+      }
+   }
+
+   root = leaves.empty() ? kNullNode : buildTopDown(leaves.data(), leaves.size());
+   if (root != kNullNode) {
+      nodes[root].parent = kNullNode;
+   }
+}
+
+void DynamicBvh::findNearest(const glm::vec3& point, std::size_t k, std::vector<ProxyId>& results) const {
+   results.clear();
+   if (root == kNullNode || k == 0) {
+      return;
+   }
+
+   using Entry = std::pair<float, NodeIndex>;
+   auto further = [](const Entry& first, const Entry& second) {
+      return first.first > second.first;
+   };
+
+   // Best first search: nodes are visited in order of distance, so leaves are found nearest first
+   std::priority_queue<Entry, std::vector<Entry>, decltype(further)> open(further);
+   open.push(Entry(distanceSquared(nodes[root].box, point), root));
+
+   while (!open.empty() && results.size() < k) {
+      Entry entry = open.top();
+      open.pop();
+
+      const Node& node = nodes[entry.second];
+      if (node.isLeaf()) {
+         results.push_back(static_cast<ProxyId>(entry.second));
+      } else {
+         open.push(Entry(distanceSquared(nodes[node.child1].box, point), node.child1));
+         open.push(Entry(distanceSquared(nodes[node.child2].box, point), node.child2));
+      }
+   }
+}
+
+DynamicBvh::NodeIndex DynamicBvh::allocateNode() {
+   NodeIndex index = freeList;
+   if (index == kNullNode) {
+      index = static_cast<NodeIndex>(nodes.size());
+      nodes.emplace_back();
+   } else {
+      freeList = nodes[index].parent;
+   }
+
+   Node& node = nodes[index];
+   node.box = BoundingBox();
+   node.userData = nullptr;
+   node.parent = kNullNode;
+   node.child1 = kNullNode;
+   node.child2 = kNullNode;
+   node.height = 0;
+
+   return index;
+}
+
+void DynamicBvh::freeNode(NodeIndex index) {
+   nodes[index].parent = freeList;
+   nodes[index].height = -1;
+   freeList = index;
+}
+
+void DynamicBvh::insertLeaf(NodeIndex leaf) {
+   if (root == kNullNode) {
+      root = leaf;
+      nodes[root].parent = kNullNode;
+      return;
+   }
+
+   // Find the best sibling, descending while pushing the leaf further down is cheaper than pairing it here
+   BoundingBox leafBox = nodes[leaf].box;
+   NodeIndex index = root;
+   while (!nodes[index].isLeaf()) {
+      const Node& node = nodes[index];
+
+      float area = surfaceArea(node.box);
+      float combinedArea = surfaceArea(merge(node.box, leafBox));
+
+      // Cost of creating a new parent for this node and the new leaf
+      float cost = 2.0f * combinedArea;
+
+      // Minimum cost of pushing the leaf further down the tree
+      float inheritanceCost = 2.0f * (combinedArea - area);
+
+      float childCosts[2];
+      NodeIndex children[2] = { node.child1, node.child2 };
+      for (int i = 0; i < 2; ++i) {
+         const Node& child = nodes[children[i]];
+         float mergedArea = surfaceArea(merge(child.box, leafBox));
+         childCosts[i] = (child.isLeaf() ? mergedArea : mergedArea - surfaceArea(child.box)) + inheritanceCost;
+      }
+
+      if (cost < childCosts[0] && cost < childCosts[1]) {
+         break;
+      }
+
+      index = childCosts[0] < childCosts[1] ? children[0] : children[1];
+   }
+
+   NodeIndex sibling = index;
+   NodeIndex oldParent = nodes[sibling].parent;
+
+   // May reallocate nodes
+   NodeIndex newParent = allocateNode();
+   nodes[newParent].parent = oldParent;
+   nodes[newParent].box = merge(leafBox, nodes[sibling].box);
+   nodes[newParent].height = nodes[sibling].height + 1;
+   nodes[newParent].child1 = sibling;
+   nodes[newParent].child2 = leaf;
+   nodes[sibling].parent = newParent;
+   nodes[leaf].parent = newParent;
+
+   if (oldParent == kNullNode) {
+      root = newParent;
+   } else if (nodes[oldParent].child1 == sibling) {
+      nodes[oldParent].child1 = newParent;
+   } else {
+      nodes[oldParent].child2 = newParent;
+   }
+
+   refitAncestors(nodes[leaf].parent);
+}
+
+void DynamicBvh::removeLeaf(NodeIndex leaf) {
+   if (leaf == root) {
+      root = kNullNode;
+      return;
+   }
+
+   NodeIndex parent = nodes[leaf].parent;
+   NodeIndex grandParent = nodes[parent].parent;
+   NodeIndex sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+   freeNode(parent);
+   nodes[leaf].parent = kNullNode;
+
+   if (grandParent == kNullNode) {
+      root = sibling;
+      nodes[sibling].parent = kNullNode;
+      return;
+   }
+
+   if (nodes[grandParent].child1 == parent) {
+      nodes[grandParent].child1 = sibling;
+   } else {
+      nodes[grandParent].child2 = sibling;
+   }
+   nodes[sibling].parent = grandParent;
+
+   refitAncestors(grandParent);
+}
+
+void DynamicBvh::refitAncestors(NodeIndex index) {
+   while (index != kNullNode) {
+      index = balance(index);
+
+      Node& node = nodes[index];
+      const Node& child1 = nodes[node.child1];
+      const Node& child2 = nodes[node.child2];
+      node.height = 1 + std::max(child1.height, child2.height);
+      node.box = merge(child1.box, child2.box);
+
+      index = node.parent;
+   }
+}
+
+DynamicBvh::NodeIndex DynamicBvh::balance(NodeIndex indexA) {
+   Node& a = nodes[indexA];
+   if (a.isLeaf() || a.height < 2) {
+      return indexA;
+   }
+
+   NodeIndex indexB = a.child1;
+   NodeIndex indexC = a.child2;
+   Node& b = nodes[indexB];
+   Node& c = nodes[indexC];
+
+   int heightDifference = c.height - b.height;
+
+   // Rotate C up
+   if (heightDifference > 1) {
+      NodeIndex indexF = c.child1;
+      NodeIndex indexG = c.child2;
+      Node& f = nodes[indexF];
+      Node& g = nodes[indexG];
+
+      c.child1 = indexA;
+      c.parent = a.parent;
+      a.parent = indexC;
+
+      if (c.parent == kNullNode) {
+         root = indexC;
+      } else if (nodes[c.parent].child1 == indexA) {
+         nodes[c.parent].child1 = indexC;
+      } else {
+         nodes[c.parent].child2 = indexC;
+      }
+
+      // Keep the taller of C's children, and give the other one to A
+      if (f.height > g.height) {
+         c.child2 = indexF;
+         a.child2 = indexG;
+         g.parent = indexA;
+         a.box = merge(b.box, g.box);
+         c.box = merge(a.box, f.box);
+         a.height = 1 + std::max(b.height, g.height);
+         c.height = 1 + std::max(a.height, f.height);
+      } else {
+         c.child2 = indexG;
+         a.child2 = indexF;
+         f.parent = indexA;
+         a.box = merge(b.box, f.box);
+         c.box = merge(a.box, g.box);
+         a.height = 1 + std::max(b.height, f.height);
+         c.height = 1 + std::max(a.height, g.height);
+      }
+
+      return indexC;
+   }
+
+   // Rotate B up
+   if (heightDifference < -1) {
+      NodeIndex indexD = b.child1;
+      NodeIndex indexE = b.child2;
+      Node& d = nodes[indexD];
+      Node& e = nodes[indexE];
+
+      b.child1 = indexA;
+      b.parent = a.parent;
+      a.parent = indexB;
+
+      if (b.parent == kNullNode) {
+         root = indexB;
+      } else if (nodes[b.parent].child1 == indexA) {
+         nodes[b.parent].child1 = indexB;
+      } else {
+         nodes[b.parent].child2 = indexB;
+      }
+
+      if (d.height > e.height) {
+         b.child2 = indexD;
+         a.child1 = indexE;
+         e.parent = indexA;
+         a.box = merge(c.box, e.box);
+         b.box = merge(a.box, d.box);
+         a.height = 1 + std::max(c.height, e.height);
+         b.height = 1 + std::max(a.height, d.height);
+      } else {
+         b.child2 = indexE;
+         a.child1 = indexD;
+         d.parent = indexA;
+         a.box = merge(c.box, d.box);
+         b.box = merge(a.box, e.box);
+         a.height = 1 + std::max(c.height, d.height);
+         b.height = 1 + std::max(a.height, e.height);
+      }
+
+      return indexB;
+   }
+
+   return indexA;
+}
+
+DynamicBvh::NodeIndex DynamicBvh::buildTopDown(NodeIndex* leaves, std::size_t count) {
+   if (count == 1) {
+      return leaves[0];
+   }
+
+   // Split at the median of the axis along which the leaf centers are most spread out
+   BoundingBox centerBounds;
+   for (std::size_t i = 0; i < count; ++i) {
+      centerBounds.addPoint(nodes[leaves[i]].box.getCenter());
+   }
+
+   glm::vec3 spread = centerBounds.max - centerBounds.min;
+   int axis = spread.x > spread.y ? (spread.x > spread.z ? 0 : 2) : (spread.y > spread.z ? 1 : 2);
+
+   std::size_t half = count / 2;
+   std::nth_element(leaves, leaves + half, leaves + count, [this, axis](NodeIndex first, NodeIndex second) {
+      return nodes[first].box.getCenter()[axis] < nodes[second].box.getCenter()[axis];
+   });
+
+   NodeIndex child1 = buildTopDown(leaves, half);
+   NodeIndex child2 = buildTopDown(leaves + half, count - half);
+
+   NodeIndex index = allocateNode();
+   Node& node = nodes[index];
+   node.child1 = child1;
+   node.child2 = child2;
+   node.box = merge(nodes[child1].box, nodes[child2].box);
+   node.height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+   nodes[child1].parent = index;
+   nodes[child2].parent = index;
+
+   return index;
+}
+
+} // namespace Shiny
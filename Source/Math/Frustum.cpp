@@ -0,0 +1,144 @@
+#include "Shiny/Math/Frustum.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define SHINY_FRUSTUM_SSE 1
+#  include <emmintrin.h>
+#endif
+
+namespace Shiny {
+
+namespace {
+
+glm::vec4 normalizePlane(const glm::vec4& plane) {
+   float length = glm::length(glm::vec3(plane));
+   return length > 0.0f ? plane / length : plane;
+}
+
+float distanceToPlane(const glm::vec4& plane, const glm::vec3& point) {
+   return glm::dot(glm::vec3(plane), point) + plane.w;
+}
+
+} // namespace
+
+Frustum::Frustum() {
+   planes.fill(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+}
+
+// static
+Frustum Frustum::fromMatrix(const glm::mat4& viewProjection) {
+   glm::vec4 rows[4];
+   for (int row = 0; row < 4; ++row) {
+      rows[row] = glm::vec4(viewProjection[0][row], viewProjection[1][row], viewProjection[2][row], viewProjection[3][row]);
+   }
+
+   Frustum frustum;
+   frustum.planes[kLeft] = normalizePlane(rows[3] + rows[0]);
+   frustum.planes[kRight] = normalizePlane(rows[3] - rows[0]);
+   frustum.planes[kBottom] = normalizePlane(rows[3] + rows[1]);
+   frustum.planes[kTop] = normalizePlane(rows[3] - rows[1]);
+   frustum.planes[kNear] = normalizePlane(rows[3] + rows[2]);
+   frustum.planes[kFar] = normalizePlane(rows[3] - rows[2]);
+
+   return frustum;
+}
+
+bool Frustum::intersects(const BoundingSphere& sphere) const {
+   for (const glm::vec4& plane : planes) {
+      if (distanceToPlane(plane, sphere.center) < -sphere.radius) {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+bool Frustum::intersects(const BoundingBox& box) const {
+   if (box.isEmpty()) {
+      return false;
+   }
+
+   for (const glm::vec4& plane : planes) {
+      // Test the corner furthest along the plane's normal
+      glm::vec3 corner(plane.x >= 0.0f ? box.max.x : box.min.x,
+                       plane.y >= 0.0f ? box.max.y : box.min.y,
+                       plane.z >= 0.0f ? box.max.z : box.min.z);
+
+      if (distanceToPlane(plane, corner) < 0.0f) {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+#if SHINY_FRUSTUM_SSE
+
+std::size_t Frustum::cullSpheres(const BoundingSphere* spheres, std::size_t count, std::uint32_t* visibleIndices) const {
+   const std::size_t kWidth = 4;
+
+   __m128 planeX[kNumPlanes];
+   __m128 planeY[kNumPlanes];
+   __m128 planeZ[kNumPlanes];
+   __m128 planeW[kNumPlanes];
+   for (int i = 0; i < kNumPlanes; ++i) {
+      planeX[i] = _mm_set1_ps(planes[i].x);
+      planeY[i] = _mm_set1_ps(planes[i].y);
+      planeZ[i] = _mm_set1_ps(planes[i].z);
+      planeW[i] = _mm_set1_ps(planes[i].w);
+   }
+
+   std::size_t numVisible = 0;
+   for (std::size_t begin = 0; begin < count; begin += kWidth) {
+      std::size_t blockCount = std::min(kWidth, count - begin);
+
+      alignas(16) float data[4][kWidth] = {};
+      for (std::size_t i = 0; i < blockCount; ++i) {
+         const BoundingSphere& sphere = spheres[begin + i];
+
+         data[0][i] = sphere.center.x;
+         data[1][i] = sphere.center.y;
+         data[2][i] = sphere.center.z;
+         data[3][i] = sphere.radius;
+      }
+
+      __m128 centerX = _mm_load_ps(data[0]);
+      __m128 centerY = _mm_load_ps(data[1]);
+      __m128 centerZ = _mm_load_ps(data[2]);
+      __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_load_ps(data[3]));
+
+      __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+      for (int i = 0; i < kNumPlanes; ++i) {
+         __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[i], centerX), _mm_mul_ps(planeY[i], centerY)),
+                                      _mm_add_ps(_mm_mul_ps(planeZ[i], centerZ), planeW[i]));
+         inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+      }
+
+      int insideMask = _mm_movemask_ps(inside);
+      for (std::size_t i = 0; i < blockCount; ++i) {
+         if (insideMask & (1 << i)) {
+            visibleIndices[numVisible++] = static_cast<std::uint32_t>(begin + i);
+         }
+      }
+   }
+
+   return numVisible;
+}
+
+#else // SHINY_FRUSTUM_SSE
+
+std::size_t Frustum::cullSpheres(const BoundingSphere* spheres, std::size_t count, std::uint32_t* visibleIndices) const {
+   std::size_t numVisible = 0;
+   for (std::size_t i = 0; i < count; ++i) {
+      if (intersects(spheres[i])) {
+         visibleIndices[numVisible++] = static_cast<std::uint32_t>(i);
+      }
+   }
+
+   return numVisible;
+}
+
+#endif // SHINY_FRUSTUM_SSE
+
+} // namespace Shiny
@@ -0,0 +1,378 @@
+#include "Shiny/Math/MathUtils.h"
+#include "Shiny/Math/TransformBatch.h"
+
+#include <algorithm>
+
+#if defined(__AVX__)
+#  define SHINY_TRANSFORM_BATCH_AVX 1
+#  include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define SHINY_TRANSFORM_BATCH_SSE 1
+#  include <emmintrin.h>
+#endif
+
+namespace Shiny {
+
+namespace TransformBatch {
+
+#if SHINY_TRANSFORM_BATCH_AVX || SHINY_TRANSFORM_BATCH_SSE
+
+namespace {
+
+#if SHINY_TRANSFORM_BATCH_AVX
+
+struct Lanes {
+   static const std::size_t kWidth = 8;
+
+   Lanes() = default;
+
+   Lanes(__m256 inValue)
+      : value(inValue) {
+   }
+
+   static Lanes load(const float* data) {
+      return _mm256_load_ps(data);
+   }
+
+   static Lanes broadcast(float scalar) {
+      return _mm256_set1_ps(scalar);
+   }
+
+   void store(float* data) const {
+      _mm256_store_ps(data, value);
+   }
+
+   __m256 value;
+};
+
+Lanes operator+(Lanes first, Lanes second) {
+   return _mm256_add_ps(first.value, second.value);
+}
+
+Lanes operator-(Lanes first, Lanes second) {
+   return _mm256_sub_ps(first.value, second.value);
+}
+
+Lanes operator-(Lanes val) {
+   return _mm256_xor_ps(_mm256_set1_ps(-0.0f), val.value);
+}
+
+Lanes operator*(Lanes first, Lanes second) {
+   return _mm256_mul_ps(first.value, second.value);
+}
+
+Lanes operator/(Lanes first, Lanes second) {
+   return _mm256_div_ps(first.value, second.value);
+}
+
+Lanes safeReciprocal(Lanes val) {
+   __m256 absVal = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), val.value);
+   __m256 tooSmall = _mm256_cmp_ps(absVal, _mm256_set1_ps(MathUtils::kSmallNumber), _CMP_LE_OQ);
+   return _mm256_andnot_ps(tooSmall, _mm256_div_ps(_mm256_set1_ps(1.0f), val.value));
+}
+
+#else // SHINY_TRANSFORM_BATCH_AVX
+
+struct Lanes {
+   static const std::size_t kWidth = 4;
+
+   Lanes() = default;
+
+   Lanes(__m128 inValue)
+      : value(inValue) {
+   }
+
+   static Lanes load(const float* data) {
+      return _mm_load_ps(data);
+   }
+
+   static Lanes broadcast(float scalar) {
+      return _mm_set1_ps(scalar);
+   }
+
+   void store(float* data) const {
+      _mm_store_ps(data, value);
+   }
+
+   __m128 value;
+};
+
+Lanes operator+(Lanes first, Lanes second) {
+   return _mm_add_ps(first.value, second.value);
+}
+
+Lanes operator-(Lanes first, Lanes second) {
+   return _mm_sub_ps(first.value, second.value);
+}
+
+Lanes operator-(Lanes val) {
+   return _mm_xor_ps(_mm_set1_ps(-0.0f), val.value);
+}
+
+Lanes operator*(Lanes first, Lanes second) {
+   return _mm_mul_ps(first.value, second.value);
+}
+
+Lanes operator/(Lanes first, Lanes second) {
+   return _mm_div_ps(first.value, second.value);
+}
+
+Lanes safeReciprocal(Lanes val) {
+   __m128 absVal = _mm_andnot_ps(_mm_set1_ps(-0.0f), val.value);
+   __m128 tooSmall = _mm_cmple_ps(absVal, _mm_set1_ps(MathUtils::kSmallNumber));
+   return _mm_andnot_ps(tooSmall, _mm_div_ps(_mm_set1_ps(1.0f), val.value));
+}
+
+#endif // SHINY_TRANSFORM_BATCH_AVX
+
+const std::size_t kWidth = Lanes::kWidth;
+
+struct Vec3Lanes {
+   Lanes x, y, z;
+};
+
+Vec3Lanes operator+(const Vec3Lanes& first, const Vec3Lanes& second) {
+   return { first.x + second.x, first.y + second.y, first.z + second.z };
+}
+
+Vec3Lanes operator*(const Vec3Lanes& first, const Vec3Lanes& second) {
+   return { first.x * second.x, first.y * second.y, first.z * second.z };
+}
+
+Vec3Lanes operator*(const Vec3Lanes& vec, Lanes scalar) {
+   return { vec.x * scalar, vec.y * scalar, vec.z * scalar };
+}
+
+Vec3Lanes cross(const Vec3Lanes& first, const Vec3Lanes& second) {
+   return { first.y * second.z - second.y * first.z,
+            first.z * second.x - second.z * first.x,
+            first.x * second.y - second.x * first.y };
+}
+
+struct QuatLanes {
+   Lanes x, y, z, w;
+};
+
+// Same operation order as glm, so that results stay as close as possible to the scalar versions
+
+QuatLanes multiply(const QuatLanes& p, const QuatLanes& q) {
+   return { p.w * q.x + p.x * q.w + p.y * q.z - p.z * q.y,
+            p.w * q.y + p.y * q.w + p.z * q.x - p.x * q.z,
+            p.w * q.z + p.z * q.w + p.x * q.y - p.y * q.x,
+            p.w * q.w - p.x * q.x - p.y * q.y - p.z * q.z };
+}
+
+Vec3Lanes rotate(const QuatLanes& q, const Vec3Lanes& v) {
+   Vec3Lanes quatVector = { q.x, q.y, q.z };
+   Vec3Lanes uv = cross(quatVector, v);
+   Vec3Lanes uuv = cross(quatVector, uv);
+
+   return v + (uv * q.w + uuv) * Lanes::broadcast(2.0f);
+}
+
+QuatLanes inverse(const QuatLanes& q) {
+   Lanes lengthSquared = q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w;
+   return { -q.x / lengthSquared, -q.y / lengthSquared, -q.z / lengthSquared, q.w / lengthSquared };
+}
+
+/**
+ * Columns of the rotation matrix of each quaternion
+ */
+void toRotationColumns(const QuatLanes& q, Vec3Lanes columns[3]) {
+   Lanes one = Lanes::broadcast(1.0f);
+   Lanes two = Lanes::broadcast(2.0f);
+
+   Lanes qxx = q.x * q.x;
+   Lanes qyy = q.y * q.y;
+   Lanes qzz = q.z * q.z;
+   Lanes qxz = q.x * q.z;
+   Lanes qxy = q.x * q.y;
+   Lanes qyz = q.y * q.z;
+   Lanes qwx = q.w * q.x;
+   Lanes qwy = q.w * q.y;
+   Lanes qwz = q.w * q.z;
+
+   columns[0] = { one - two * (qyy + qzz), two * (qxy + qwz), two * (qxz - qwy) };
+   columns[1] = { two * (qxy - qwz), one - two * (qxx + qzz), two * (qyz + qwx) };
+   columns[2] = { two * (qxz + qwy), two * (qyz - qwx), one - two * (qxx + qyy) };
+}
+
+struct TransformBlock {
+   QuatLanes orientation;
+   Vec3Lanes position;
+   Vec3Lanes scale;
+};
+
+/**
+ * Transposes up to kWidth transforms into lanes, padding partial blocks with identity transforms
+ */
+TransformBlock loadBlock(const Transform* transforms, std::size_t count) {
+   static const Transform kIdentity;
+
+   alignas(32) float data[10][kWidth];
+   for (std::size_t i = 0; i < kWidth; ++i) {
+      const Transform& transform = i < count ? transforms[i] : kIdentity;
+
+      data[0][i] = transform.orientation.x;
+      data[1][i] = transform.orientation.y;
+      data[2][i] = transform.orientation.z;
+      data[3][i] = transform.orientation.w;
+      data[4][i] = transform.position.x;
+      data[5][i] = transform.position.y;
+      data[6][i] = transform.position.z;
+      data[7][i] = transform.scale.x;
+      data[8][i] = transform.scale.y;
+      data[9][i] = transform.scale.z;
+   }
+
+   TransformBlock block;
+   block.orientation = { Lanes::load(data[0]), Lanes::load(data[1]), Lanes::load(data[2]), Lanes::load(data[3]) };
+   block.position = { Lanes::load(data[4]), Lanes::load(data[5]), Lanes::load(data[6]) };
+   block.scale = { Lanes::load(data[7]), Lanes::load(data[8]), Lanes::load(data[9]) };
+
+   return block;
+}
+
+void storeBlock(Transform* transforms, std::size_t count, const TransformBlock& block) {
+   alignas(32) float data[10][kWidth];
+   block.orientation.x.store(data[0]);
+   block.orientation.y.store(data[1]);
+   block.orientation.z.store(data[2]);
+   block.orientation.w.store(data[3]);
+   block.position.x.store(data[4]);
+   block.position.y.store(data[5]);
+   block.position.z.store(data[6]);
+   block.scale.x.store(data[7]);
+   block.scale.y.store(data[8]);
+   block.scale.z.store(data[9]);
+
+   for (std::size_t i = 0; i < count; ++i) {
+      Transform& transform = transforms[i];
+
+      transform.orientation.x = data[0][i];
+      transform.orientation.y = data[1][i];
+      transform.orientation.z = data[2][i];
+      transform.orientation.w = data[3][i];
+      transform.position = glm::vec3(data[4][i], data[5][i], data[6][i]);
+      transform.scale = glm::vec3(data[7][i], data[8][i], data[9][i]);
+   }
+}
+
+/**
+ * Writes the upper 3x4 of each matrix (the last row is always (0, 0, 0, 1) for transforms)
+ */
+void storeMatrices(glm::mat4* matrices, std::size_t count, const Vec3Lanes columns[4]) {
+   alignas(32) float data[4][3][kWidth];
+   for (int column = 0; column < 4; ++column) {
+      columns[column].x.store(data[column][0]);
+      columns[column].y.store(data[column][1]);
+      columns[column].z.store(data[column][2]);
+   }
+
+   for (std::size_t i = 0; i < count; ++i) {
+      glm::mat4& matrix = matrices[i];
+
+      for (int column = 0; column < 4; ++column) {
+         matrix[column] = glm::vec4(data[column][0][i], data[column][1][i], data[column][2][i], column == 3 ? 1.0f : 0.0f);
+      }
+   }
+}
+
+} // namespace
+
+void multiply(Transform* results, const Transform* first, const Transform* second, std::size_t count) {
+   for (std::size_t begin = 0; begin < count; begin += kWidth) {
+      std::size_t blockCount = std::min(kWidth, count - begin);
+      TransformBlock firstBlock = loadBlock(first + begin, blockCount);
+      TransformBlock secondBlock = loadBlock(second + begin, blockCount);
+
+      TransformBlock resultBlock;
+      resultBlock.orientation = multiply(secondBlock.orientation, firstBlock.orientation);
+      resultBlock.scale = secondBlock.scale * firstBlock.scale;
+      resultBlock.position = rotate(secondBlock.orientation, secondBlock.scale * firstBlock.position) + secondBlock.position;
+
+      storeBlock(results + begin, blockCount, resultBlock);
+   }
+}
+
+void inverse(Transform* results, const Transform* transforms, std::size_t count) {
+   for (std::size_t begin = 0; begin < count; begin += kWidth) {
+      std::size_t blockCount = std::min(kWidth, count - begin);
+      TransformBlock block = loadBlock(transforms + begin, blockCount);
+
+      TransformBlock resultBlock;
+      resultBlock.orientation = inverse(block.orientation);
+      resultBlock.scale = { safeReciprocal(block.scale.x), safeReciprocal(block.scale.y), safeReciprocal(block.scale.z) };
+
+      Vec3Lanes negatedPosition = { -block.position.x, -block.position.y, -block.position.z };
+      resultBlock.position = rotate(resultBlock.orientation, resultBlock.scale * negatedPosition);
+
+      storeBlock(results + begin, blockCount, resultBlock);
+   }
+}
+
+void toMatrix(glm::mat4* results, const Transform* transforms, std::size_t count) {
+   for (std::size_t begin = 0; begin < count; begin += kWidth) {
+      std::size_t blockCount = std::min(kWidth, count - begin);
+      TransformBlock block = loadBlock(transforms + begin, blockCount);
+
+      Vec3Lanes columns[4];
+      toRotationColumns(block.orientation, columns);
+      columns[0] = columns[0] * block.scale.x;
+      columns[1] = columns[1] * block.scale.y;
+      columns[2] = columns[2] * block.scale.z;
+      columns[3] = block.position;
+
+      storeMatrices(results + begin, blockCount, columns);
+   }
+}
+
+void toNormalMatrix(glm::mat4* results, const Transform* transforms, std::size_t count) {
+   Lanes zero = Lanes::broadcast(0.0f);
+
+   for (std::size_t begin = 0; begin < count; begin += kWidth) {
+      std::size_t blockCount = std::min(kWidth, count - begin);
+      TransformBlock block = loadBlock(transforms + begin, blockCount);
+
+      Vec3Lanes columns[4];
+      toRotationColumns(block.orientation, columns);
+      columns[0] = columns[0] * safeReciprocal(block.scale.x);
+      columns[1] = columns[1] * safeReciprocal(block.scale.y);
+      columns[2] = columns[2] * safeReciprocal(block.scale.z);
+      columns[3] = { zero, zero, zero };
+
+      storeMatrices(results + begin, blockCount, columns);
+   }
+}
+
+#else // SHINY_TRANSFORM_BATCH_AVX || SHINY_TRANSFORM_BATCH_SSE
+
+void multiply(Transform* results, const Transform* first, const Transform* second, std::size_t count) {
+   for (std::size_t i = 0; i < count; ++i) {
+      results[i] = first[i] * second[i];
+   }
+}
+
+void inverse(Transform* results, const Transform* transforms, std::size_t count) {
+   for (std::size_t i = 0; i < count; ++i) {
+      results[i] = transforms[i].inverse();
+   }
+}
+
+void toMatrix(glm::mat4* results, const Transform* transforms, std::size_t count) {
+   for (std::size_t i = 0; i < count; ++i) {
+      results[i] = transforms[i].toMatrix();
+   }
+}
+
+void toNormalMatrix(glm::mat4* results, const Transform* transforms, std::size_t count) {
+   for (std::size_t i = 0; i < count; ++i) {
+      results[i] = transforms[i].toNormalMatrix();
+   }
+}
+
+#endif // SHINY_TRANSFORM_BATCH_AVX || SHINY_TRANSFORM_BATCH_SSE
+
+} // namespace TransformBatch
+
+} // namespace Shiny
@@ -0,0 +1,136 @@
+#include "Shiny/Platform/ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace Shiny {
+
+namespace {
+
+// State shared between the thread calling parallelFor() and the helper tasks, which may outlive the call (if the caller
+// finishes every chunk before a helper gets to run)
+struct ParallelForState {
+   ParallelForState(std::size_t inCount, std::size_t inChunkSize, std::size_t inNumChunks, const ThreadPool::RangeFunc& inFunction)
+      : count(inCount), chunkSize(inChunkSize), numChunks(inNumChunks), function(inFunction), nextChunk(0), completedChunks(0) {
+   }
+
+   // Processes chunks until there are none left
+   void work() {
+      std::size_t numCompleted = 0;
+
+      std::size_t chunk = 0;
+      while ((chunk = nextChunk.fetch_add(1)) < numChunks) {
+         std::size_t begin = chunk * chunkSize;
+         function(begin, std::min(begin + chunkSize, count));
+         ++numCompleted;
+      }
+
+      if (numCompleted > 0 && completedChunks.fetch_add(numCompleted) + numCompleted == numChunks) {
+         std::lock_guard<std::mutex> lock(mutex);
+         condition.notify_all();
+      }
+   }
+
+   const std::size_t count;
+   const std::size_t chunkSize;
+   const std::size_t numChunks;
+   const ThreadPool::RangeFunc function;
+
+   std::atomic<std::size_t> nextChunk;
+   std::atomic<std::size_t> completedChunks;
+   std::mutex mutex;
+   std::condition_variable condition;
+};
+
+} // namespace
+
+// static
+std::size_t ThreadPool::getDefaultNumThreads() {
+   unsigned int hardwareThreads = std::thread::hardware_concurrency();
+   return hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+}
+
+ThreadPool::ThreadPool(std::size_t numThreads)
+   : stopping(false) {
+   threads.reserve(numThreads);
+   for (std::size_t i = 0; i < numThreads; ++i) {
+      threads.emplace_back(&ThreadPool::workerLoop, this);
+   }
+}
+
+ThreadPool::~ThreadPool() {
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+   }
+   condition.notify_all();
+
+   for (std::thread& thread : threads) {
+      thread.join();
+   }
+}
+
+void ThreadPool::enqueue(Task task) {
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      tasks.push_back(std::move(task));
+   }
+   condition.notify_one();
+}
+
+void ThreadPool::parallelFor(std::size_t count, std::size_t minChunkSize, const RangeFunc& function) {
+   if (count == 0) {
+      return;
+   }
+
+   // Aim for a few chunks per thread, so that uneven chunks balance out
+   std::size_t numParticipants = threads.size() + 1;
+   std::size_t chunkSize = std::max(std::max(minChunkSize, std::size_t(1)), (count + numParticipants * 4 - 1) / (numParticipants * 4));
+   std::size_t numChunks = (count + chunkSize - 1) / chunkSize;
+
+   if (numChunks == 1) {
+      function(0, count);
+      return;
+   }
+
+   std::shared_ptr<ParallelForState> state = std::make_shared<ParallelForState>(count, chunkSize, numChunks, function);
+
+   std::size_t numHelpers = std::min(threads.size(), numChunks - 1);
+   for (std::size_t i = 0; i < numHelpers; ++i) {
+      enqueue([state]() {
+         state->work();
+      });
+   }
+
+   state->work();
+
+   std::unique_lock<std::mutex> lock(state->mutex);
+   state->condition.wait(lock, [&state]() {
+      return state->completedChunks.load() == state->numChunks;
+   });
+}
+
+void ThreadPool::workerLoop() {
+   while (true) {
+      Task task;
+
+      {
+         std::unique_lock<std::mutex> lock(mutex);
+         condition.wait(lock, [this]() {
+            return stopping || !tasks.empty();
+         });
+
+         if (stopping && tasks.empty()) {
+            return;
+         }
+
+         task = std::move(tasks.front());
+         tasks.pop_front();
+      }
+
+      task();
+   }
+}
+
+} // namespace Shiny
@@ -1,3 +1,4 @@
+#include "Shiny/Graphics/Context.h"
 #include "Shiny/Scene/CameraComponent.h"
 
 #include <glm/gtc/matrix_transform.hpp>
@@ -11,6 +12,9 @@ const glm::vec3 kFront(0.0f, 0.0f, -1.0f);
 const glm::vec3 kRight(1.0f, 0.0f, 0.0f);
 const glm::vec3 kUp(0.0f, 1.0f, 0.0f);
 
+// Used when there is no viewport to follow
+const float kDefaultAspectRatio = 16.0f / 9.0f;
+
 } // namespace
 
 glm::vec3 CameraComponent::getFront() const {
@@ -26,26 +30,55 @@ glm::vec3 CameraComponent::getUp() const {
 }
 
 glm::mat4 CameraComponent::getViewMatrix() const {
-   Transform absoluteTransform = getAbsoluteTransform();
-   return glm::lookAt(absoluteTransform.position, absoluteTransform.position + getFront(), kUp);
+   const Transform& absoluteTransform = getAbsoluteTransform();
+   return glm::lookAt(absoluteTransform.position, absoluteTransform.position + kFront * absoluteTransform.orientation, kUp);
+}
+
+glm::mat4 CameraComponent::getProjectionMatrix() const {
+   return glm::perspective(glm::radians(fov), getAspectRatio(), nearPlane, farPlane);
+}
+
+float CameraComponent::getAspectRatio() const {
+   if (aspectRatio > 0.0f) {
+      return aspectRatio;
+   }
+
+   if (const Context* context = Context::current()) {
+      Viewport viewport = context->getViewport();
+      if (viewport.width > 0 && viewport.height > 0) {
+         return static_cast<float>(viewport.width) / viewport.height;
+      }
+   }
+
+   return kDefaultAspectRatio;
+}
+
+Frustum CameraComponent::getFrustum() const {
+   return Frustum::fromMatrix(getProjectionMatrix() * getViewMatrix());
 }
 
 void CameraComponent::fly(float amount) {
+   Transform relativeTransform = getRelativeTransform();
    relativeTransform.position += getFront() * amount;
+   setRelativeTransform(relativeTransform);
 }
 
 void CameraComponent::strafe(float amount) {
+   Transform relativeTransform = getRelativeTransform();
    relativeTransform.position += getRight() * amount;
+   setRelativeTransform(relativeTransform);
 }
 
 void CameraComponent::rotate(float pitch, float yaw) {
    glm::quat pitchChange = glm::angleAxis(pitch, kRight);
    glm::quat yawChange = glm::angleAxis(yaw, kUp);
+   Transform relativeTransform = getRelativeTransform();
    relativeTransform.orientation = glm::normalize(pitchChange * relativeTransform.orientation * yawChange);
+   setRelativeTransform(relativeTransform);
 }
 
 void CameraComponent::lookAt(const glm::vec3& loc) {
-   ASSERT(relativeTransform.position != loc, "Camera trying to look at self");
+   ASSERT(getRelativeTransform().position != loc, "Camera trying to look at self");
 
    Transform absoluteTransform = getAbsoluteTransform();
    absoluteTransform.orientation = glm::toQuat(glm::lookAt(absoluteTransform.position, loc, kUp));
@@ -11,6 +11,13 @@ void DirectionalLightComponent::apply(ShaderProgram& program, RenderData& render
    }
 }
 
+void DirectionalLightComponent::writeFrameData(FrameUniformData::Light& light) const {
+   LightComponent::writeFrameData(light);
+
+   light.color.a = static_cast<float>(FrameUniforms::kDirectional);
+   light.directionBeam = glm::vec4(getAbsoluteTransform().orientation * glm::vec3(0.0f, 0.0f, -1.0f), 0.0f);
+}
+
 SHINY_REGISTER_COMPONENT(DirectionalLightComponent)
 
 } // namespace Shiny
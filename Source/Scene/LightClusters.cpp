@@ -0,0 +1,335 @@
+#include "Shiny/ShinyAssert.h"
+#include "Shiny/Graphics/Context.h"
+#include "Shiny/Graphics/RenderData.h"
+#include "Shiny/Graphics/ShaderProgram.h"
+#include "Shiny/Scene/CameraComponent.h"
+#include "Shiny/Scene/LightClusters.h"
+#include "Shiny/Scene/LightComponent.h"
+#include "Shiny/Scene/Scene.h"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define SHINY_LIGHT_CLUSTERS_SSE 1
+#  include <emmintrin.h>
+#endif
+
+namespace Shiny {
+
+namespace {
+
+#if SHINY_LIGHT_CLUSTERS_SSE
+
+/**
+ * Finds the tiles whose bounds are within the radius of the point, given the squared distance along the depth axis
+ */
+std::size_t findOverlappingTiles(const float* minX, const float* maxX, const float* minY, const float* maxY, float centerX, float centerY, float depthDistanceSquared, float radiusSquared, std::uint32_t* tiles) {
+   static_assert(LightClusters::kTilesPerSlice % 4 == 0, "Tiles must come in blocks of four");
+
+   __m128 x = _mm_set1_ps(centerX);
+   __m128 y = _mm_set1_ps(centerY);
+   __m128 zero = _mm_setzero_ps();
+   __m128 remaining = _mm_set1_ps(radiusSquared - depthDistanceSquared);
+
+   std::size_t numTiles = 0;
+   for (int begin = 0; begin < LightClusters::kTilesPerSlice; begin += 4) {
+      __m128 distanceX = _mm_max_ps(zero, _mm_max_ps(_mm_sub_ps(_mm_load_ps(minX + begin), x), _mm_sub_ps(x, _mm_load_ps(maxX + begin))));
+      __m128 distanceY = _mm_max_ps(zero, _mm_max_ps(_mm_sub_ps(_mm_load_ps(minY + begin), y), _mm_sub_ps(y, _mm_load_ps(maxY + begin))));
+      __m128 distanceSquared = _mm_add_ps(_mm_mul_ps(distanceX, distanceX), _mm_mul_ps(distanceY, distanceY));
+
+      int overlapMask = _mm_movemask_ps(_mm_cmple_ps(distanceSquared, remaining));
+      for (int i = 0; overlapMask != 0; ++i, overlapMask >>= 1) {
+         if (overlapMask & 1) {
+            tiles[numTiles++] = static_cast<std::uint32_t>(begin + i);
+         }
+      }
+   }
+
+   return numTiles;
+}
+
+#else // SHINY_LIGHT_CLUSTERS_SSE
+
+std::size_t findOverlappingTiles(const float* minX, const float* maxX, const float* minY, const float* maxY, float centerX, float centerY, float depthDistanceSquared, float radiusSquared, std::uint32_t* tiles) {
+   std::size_t numTiles = 0;
+   for (int i = 0; i < LightClusters::kTilesPerSlice; ++i) {
+      float distanceX = std::max(0.0f, std::max(minX[i] - centerX, centerX - maxX[i]));
+      float distanceY = std::max(0.0f, std::max(minY[i] - centerY, centerY - maxY[i]));
+
+      if (distanceX * distanceX + distanceY * distanceY <= radiusSquared - depthDistanceSquared) {
+         tiles[numTiles++] = static_cast<std::uint32_t>(i);
+      }
+   }
+
+   return numTiles;
+}
+
+#endif // SHINY_LIGHT_CLUSTERS_SSE
+
+/**
+ * Whether a cone (apex, unit direction, half angle and range) may intersect a sphere
+ */
+bool coneIntersectsSphere(const glm::vec3& apex, const glm::vec3& direction, float halfAngle, float range, const glm::vec3& center, float radius) {
+   glm::vec3 offset = center - apex;
+   float offsetLengthSquared = glm::dot(offset, offset);
+   float distanceAlongAxis = glm::dot(offset, direction);
+   float distanceToAxis = std::sqrt(std::max(0.0f, offsetLengthSquared - distanceAlongAxis * distanceAlongAxis));
+
+   float distanceToCone = std::cos(halfAngle) * distanceToAxis - std::sin(halfAngle) * distanceAlongAxis;
+   return distanceToCone <= radius && distanceAlongAxis <= range + radius && distanceAlongAxis >= -radius;
+}
+
+} // namespace
+
+// static
+const int LightClusters::kTilesX;
+// static
+const int LightClusters::kTilesY;
+// static
+const int LightClusters::kSlices;
+// static
+const std::size_t LightClusters::kMaxLights;
+
+LightClusters::LightClusters()
+   : boundsFov(0.0f), boundsAspectRatio(0.0f), boundsNearPlane(0.0f), boundsFarPlane(0.0f), depthScale(0.0f),
+     depthBias(0.0f), clusterGrid(kNumClusters, glm::uvec2(0)) {
+}
+
+LightClusters::~LightClusters() {
+   // Nothing was created if the clusters were never uploaded
+   for (BufferTexture* bufferTexture : { &lightTexture, &gridTexture, &indexTexture }) {
+      if (bufferTexture->buffer != 0) {
+         Context::current()->onTextureDeleted(bufferTexture->texture);
+         Context::current()->onBufferDeleted(bufferTexture->buffer);
+         glDeleteTextures(1, &bufferTexture->texture);
+         glDeleteBuffers(1, &bufferTexture->buffer);
+      }
+   }
+}
+
+void LightClusters::assign(const Scene& scene, const CameraComponent& camera) {
+   updateClusterBounds(camera);
+
+   lights.clear();
+   lightData.clear();
+   const DynamicBvh& lightSpatialIndex = scene.getLightSpatialIndex();
+   lightSpatialIndex.query(camera.getFrustum(), [this, &lightSpatialIndex](DynamicBvh::ProxyId proxyId) {
+      if (lights.size() >= kMaxLights) {
+         return false;
+      }
+
+      lights.push_back(static_cast<LightComponent*>(lightSpatialIndex.getUserData(proxyId)));
+      return true;
+   });
+
+   lightData.resize(lights.size());
+   pairClusters.clear();
+   pairLights.clear();
+   overlappingTiles.resize(kTilesPerSlice);
+
+   glm::mat4 viewMatrix = camera.getViewMatrix();
+   for (std::size_t i = 0; i < lights.size(); ++i) {
+      lights[i]->writeFrameData(lightData[i]);
+      assignLight(static_cast<std::uint32_t>(i), viewMatrix);
+   }
+
+   // Counting sort of the pairs by cluster, so that each cluster's lights are contiguous
+   std::fill(clusterGrid.begin(), clusterGrid.end(), glm::uvec2(0));
+   for (std::uint32_t cluster : pairClusters) {
+      ++clusterGrid[cluster].y;
+   }
+
+   std::uint32_t offset = 0;
+   for (glm::uvec2& cell : clusterGrid) {
+      cell.x = offset;
+      offset += cell.y;
+   }
+
+   lightIndices.resize(pairClusters.size());
+   for (std::size_t i = 0; i < pairClusters.size(); ++i) {
+      glm::uvec2& cell = clusterGrid[pairClusters[i]];
+      lightIndices[cell.x++] = pairLights[i];
+   }
+
+   // Filling moved each offset to the end of its cluster
+   for (glm::uvec2& cell : clusterGrid) {
+      cell.x -= cell.y;
+   }
+}
+
+void LightClusters::upload() {
+   uploadBufferTexture(lightTexture, GL_RGBA32F, lightData.data(), lightData.size() * sizeof(FrameUniformData::Light));
+   uploadBufferTexture(gridTexture, GL_RG32UI, clusterGrid.data(), clusterGrid.size() * sizeof(glm::uvec2));
+   uploadBufferTexture(indexTexture, GL_R32UI, lightIndices.data(), lightIndices.size() * sizeof(std::uint32_t));
+}
+
+void LightClusters::apply(ShaderProgram& program, RenderData& renderData) {
+   bindBufferTexture(program, renderData, "uClusterLights", lightTexture);
+   bindBufferTexture(program, renderData, "uClusterGrid", gridTexture);
+   bindBufferTexture(program, renderData, "uClusterLightIndices", indexTexture);
+
+   if (program.hasUniform("uClusterDims")) {
+      program.setUniformValue("uClusterDims", glm::ivec3(kTilesX, kTilesY, kSlices));
+   }
+
+   if (program.hasUniform("uClusterDepthParams")) {
+      program.setUniformValue("uClusterDepthParams", glm::vec2(depthScale, depthBias));
+   }
+
+   if (program.hasUniform("uClusterTileScale")) {
+      Viewport viewport = Context::current()->getViewport();
+      glm::vec2 tileScale(viewport.width > 0 ? static_cast<float>(kTilesX) / viewport.width : 0.0f,
+                          viewport.height > 0 ? static_cast<float>(kTilesY) / viewport.height : 0.0f);
+      program.setUniformValue("uClusterTileScale", tileScale);
+   }
+}
+
+void LightClusters::updateClusterBounds(const CameraComponent& camera) {
+   float fov = camera.getFov();
+   float aspectRatio = camera.getAspectRatio();
+   float nearPlane = camera.getNearPlane();
+   float farPlane = camera.getFarPlane();
+   if (fov == boundsFov && aspectRatio == boundsAspectRatio && nearPlane == boundsNearPlane && farPlane == boundsFarPlane) {
+      return;
+   }
+
+   boundsFov = fov;
+   boundsAspectRatio = aspectRatio;
+   boundsNearPlane = nearPlane;
+   boundsFarPlane = farPlane;
+
+   ASSERT(nearPlane > 0.0f && farPlane > nearPlane, "Invalid camera planes: %f, %f", nearPlane, farPlane);
+
+   // Exponential slices keep clusters roughly cubic
+   float logDepthRange = std::log(farPlane / nearPlane);
+   depthScale = kSlices / logDepthRange;
+   depthBias = -kSlices * std::log(nearPlane) / logDepthRange;
+   for (int slice = 0; slice <= kSlices; ++slice) {
+      sliceDepths[slice] = nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(slice) / kSlices);
+   }
+
+   float tanHalfFovY = std::tan(fov * glm::pi<float>() / 360.0f);
+   float tanHalfFovX = tanHalfFovY * aspectRatio;
+
+   for (int slice = 0; slice < kSlices; ++slice) {
+      float nearDepth = sliceDepths[slice];
+      float farDepth = sliceDepths[slice + 1];
+
+      for (int tileY = 0; tileY < kTilesY; ++tileY) {
+         float ndcMinY = -1.0f + 2.0f * tileY / kTilesY;
+         float ndcMaxY = -1.0f + 2.0f * (tileY + 1) / kTilesY;
+
+         for (int tileX = 0; tileX < kTilesX; ++tileX) {
+            float ndcMinX = -1.0f + 2.0f * tileX / kTilesX;
+            float ndcMaxX = -1.0f + 2.0f * (tileX + 1) / kTilesX;
+
+            // Tile edges spread out with depth, so the extremes are on either the near or the far plane of the slice
+            int index = getClusterIndex(tileX, tileY, slice);
+            clusterMinX[index] = ndcMinX * tanHalfFovX * (ndcMinX < 0.0f ? farDepth : nearDepth);
+            clusterMaxX[index] = ndcMaxX * tanHalfFovX * (ndcMaxX > 0.0f ? farDepth : nearDepth);
+            clusterMinY[index] = ndcMinY * tanHalfFovY * (ndcMinY < 0.0f ? farDepth : nearDepth);
+            clusterMaxY[index] = ndcMaxY * tanHalfFovY * (ndcMaxY > 0.0f ? farDepth : nearDepth);
+         }
+      }
+   }
+}
+
+void LightClusters::assignLight(std::uint32_t lightIndex, const glm::mat4& viewMatrix) {
+   const FrameUniformData::Light& light = lightData[lightIndex];
+   float radius = lights[lightIndex]->getWorldBoundingSphere().radius;
+   if (!std::isfinite(radius)) {
+      return;
+   }
+
+   glm::vec3 viewPosition(viewMatrix * glm::vec4(glm::vec3(light.positionFalloff), 1.0f));
+   float depth = -viewPosition.z;
+   if (depth + radius < sliceDepths[0] || depth - radius > sliceDepths[kSlices]) {
+      return;
+   }
+
+   bool isSpot = static_cast<int>(light.color.a) == FrameUniforms::kSpot;
+   float halfAngle = light.cutoff.x;
+   bool testCone = isSpot && halfAngle < glm::half_pi<float>();
+   glm::vec3 viewDirection;
+   if (testCone) {
+      viewDirection = glm::normalize(glm::vec3(viewMatrix * glm::vec4(glm::vec3(light.directionBeam), 0.0f)));
+   }
+
+   int firstSlice = static_cast<int>(std::upper_bound(sliceDepths.begin(), sliceDepths.end(), depth - radius) - sliceDepths.begin()) - 1;
+   int lastSlice = static_cast<int>(std::upper_bound(sliceDepths.begin(), sliceDepths.end(), depth + radius) - sliceDepths.begin()) - 1;
+   firstSlice = std::max(firstSlice, 0);
+   lastSlice = std::min(lastSlice, kSlices - 1);
+
+   float radiusSquared = radius * radius;
+   for (int slice = firstSlice; slice <= lastSlice; ++slice) {
+      float depthDistance = std::max(0.0f, std::max(sliceDepths[slice] - depth, depth - sliceDepths[slice + 1]));
+      float depthDistanceSquared = depthDistance * depthDistance;
+      if (depthDistanceSquared > radiusSquared) {
+         continue;
+      }
+
+      int sliceOffset = slice * kTilesPerSlice;
+      std::size_t numTiles = findOverlappingTiles(clusterMinX.data() + sliceOffset, clusterMaxX.data() + sliceOffset,
+                                                  clusterMinY.data() + sliceOffset, clusterMaxY.data() + sliceOffset,
+                                                  viewPosition.x, viewPosition.y, depthDistanceSquared, radiusSquared,
+                                                  overlappingTiles.data());
+
+      for (std::size_t i = 0; i < numTiles; ++i) {
+         std::uint32_t cluster = static_cast<std::uint32_t>(sliceOffset) + overlappingTiles[i];
+
+         if (testCone) {
+            // Test the cone against the cluster's bounding sphere (view space, looking down -z)
+            glm::vec3 clusterMin(clusterMinX[cluster], clusterMinY[cluster], -sliceDepths[slice + 1]);
+            glm::vec3 clusterMax(clusterMaxX[cluster], clusterMaxY[cluster], -sliceDepths[slice]);
+            glm::vec3 clusterCenter = (clusterMin + clusterMax) * 0.5f;
+            float clusterRadius = glm::length(clusterMax - clusterCenter);
+
+            if (!coneIntersectsSphere(viewPosition, viewDirection, halfAngle, radius, clusterCenter, clusterRadius)) {
+               continue;
+            }
+         }
+
+         pairClusters.push_back(cluster);
+         pairLights.push_back(lightIndex);
+      }
+   }
+}
+
+void LightClusters::uploadBufferTexture(BufferTexture& bufferTexture, GLenum internalFormat, const void* data, std::size_t size) {
+   bool created = bufferTexture.buffer == 0;
+   if (created) {
+      glGenBuffers(1, &bufferTexture.buffer);
+      glGenTextures(1, &bufferTexture.texture);
+   }
+
+   // Buffer textures can't be empty, and orphaning keeps the upload from waiting on the previous frame's draws
+   Context::current()->bindBuffer(GL_TEXTURE_BUFFER, bufferTexture.buffer);
+   glBufferData(GL_TEXTURE_BUFFER, std::max<std::size_t>(size, sizeof(glm::vec4)), nullptr, GL_STREAM_DRAW);
+   if (size > 0) {
+      glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+      Context::current()->onBufferUpload(size);
+   }
+
+   if (created) {
+      Context::current()->bindTexture(Tex::Target::kBuffer, bufferTexture.texture);
+      glTexBuffer(GL_TEXTURE_BUFFER, internalFormat, bufferTexture.buffer);
+   }
+}
+
+void LightClusters::bindBufferTexture(ShaderProgram& program, RenderData& renderData, const char* uniformName, const BufferTexture& bufferTexture) const {
+   if (bufferTexture.texture == 0 || !program.hasUniform(uniformName)) {
+      return;
+   }
+
+   GLint textureUnit = renderData.aquireTextureUnit();
+   Context* context = Context::current();
+   context->activeTexture(textureUnit);
+   context->bindTexture(Tex::Target::kBuffer, bufferTexture.texture);
+
+   program.setUniformValue(uniformName, textureUnit);
+}
+
+} // namespace Shiny
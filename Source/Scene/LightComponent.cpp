@@ -2,8 +2,18 @@
 #include "Shiny/Scene/LightComponent.h"
 #include "Shiny/Scene/Scene.h"
 
+#include <cmath>
+#include <limits>
+
 namespace Shiny {
 
+namespace {
+
+// Intensity (relative to the light's color) below which a light is considered to have no effect
+const float kMinIntensity = 1.0f / 256.0f;
+
+} // namespace
+
 LightComponent::LightComponent(Entity& entity)
    : TransformComponent(entity), color(1.0f) {
    getOwner().getScene().registerLightComponent(this);
@@ -15,6 +25,27 @@ void LightComponent::apply(ShaderProgram& program, RenderData& renderData) {
    }
 }
 
+void LightComponent::writeFrameData(FrameUniformData::Light& light) const {
+   light.color = glm::vec4(color, static_cast<float>(FrameUniforms::kAmbient));
+   light.positionFalloff = glm::vec4(getAbsoluteTransform().position, 0.0f);
+   light.directionBeam = glm::vec4(0.0f);
+   light.cutoff = glm::vec4(0.0f);
+}
+
+BoundingSphere LightComponent::getWorldBoundingSphere() const {
+   return BoundingSphere(getAbsoluteTransform().position, std::numeric_limits<float>::infinity());
+}
+
+// static
+float LightComponent::getFalloffRadius(float squareFalloff) {
+   if (squareFalloff <= 0.0f) {
+      return std::numeric_limits<float>::infinity();
+   }
+
+   // Solves 1 / (1 + squareFalloff * distance^2) = kMinIntensity
+   return std::sqrt((1.0f / kMinIntensity - 1.0f) / squareFalloff);
+}
+
 SHINY_REGISTER_COMPONENT(LightComponent)
 
 } // namespace Shiny
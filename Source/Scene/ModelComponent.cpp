@@ -1,3 +1,5 @@
+#include "Shiny/ShinyAssert.h"
+#include "Shiny/Graphics/Mesh.h"
 #include "Shiny/Graphics/ShaderProgram.h"
 #include "Shiny/Scene/ModelComponent.h"
 #include "Shiny/Scene/Scene.h"
@@ -6,35 +8,89 @@
 
 namespace Shiny {
 
-namespace {
-
-const char* kModelMatrix = "uModelMatrix";
-const char* kNormalMatrix = "uNormalMatrix";
-
-} // namespace
+// static
+const std::size_t ModelComponent::kNotUnbounded;
 
 ModelComponent::ModelComponent(Entity& entity)
-   : TransformComponent(entity) {
+   : TransformComponent(entity), translucent(false), spatialProxyId(DynamicBvh::kNullProxy), unboundedIndex(kNotUnbounded),
+     spatialUpdatePending(false), spatiallyTracked(false) {
    getOwner().getScene().registerModelComponent(this);
 }
 
+void ModelComponent::setMesh(const SPtr<Mesh>& mesh) {
+   model.setMesh(mesh);
+   getOwner().getScene().onModelBoundsChanged(this);
+}
+
+void ModelComponent::onWorldTransformInvalidated() {
+   getOwner().getScene().onModelMoved(this);
+}
+
 void ModelComponent::render(RenderData renderData) {
-   ShaderProgram* program = renderData.getOverrideProgram() ? renderData.getOverrideProgram() : model.getShaderProgram().get();
+   ShaderProgram* program = model.selectShaderProgram(renderData);
 
-   if (program && program->hasUniform(kModelMatrix)) {
-      Transform absoluteTransform = getAbsoluteTransform();
-      glm::mat4 modelMatrix = absoluteTransform.toMatrix();
-      program->setUniformValue(kModelMatrix, absoluteTransform.toMatrix());
+   // Instanced programs only read their matrices from the instance buffer
+   if (program && program->supportsInstancing()) {
+      Mesh::InstanceData instance;
+      instance.modelMatrix = getWorldMatrix();
+      instance.normalMatrix = getNormalMatrix();
 
-      if (program->hasUniform(kNormalMatrix)) {
-         glm::mat4 normalMatrix = glm::transpose(glm::inverse(modelMatrix));
-         program->setUniformValue(kNormalMatrix, normalMatrix);
+      renderInstanced(renderData, &instance, 1);
+      return;
+   }
+
+   if (program) {
+      const UniformHandle<glm::mat4>& modelMatrixUniform = program->getModelMatrixUniform();
+      if (modelMatrixUniform) {
+         modelMatrixUniform.set(getWorldMatrix());
+
+         const UniformHandle<glm::mat4>& normalMatrixUniform = program->getNormalMatrixUniform();
+         if (normalMatrixUniform) {
+            normalMatrixUniform.set(getNormalMatrix());
+         }
       }
    }
 
    model.draw(renderData);
 }
 
+void ModelComponent::renderInstanced(RenderData renderData, const Mesh::InstanceData* instances, unsigned int numInstances) {
+   ASSERT(instances && numInstances > 0);
+
+   const SPtr<Mesh>& mesh = getMesh();
+   if (!mesh) {
+      return;
+   }
+
+   mesh->setInstanceData(instances, numInstances);
+   model.drawInstanced(renderData, numInstances);
+}
+
+bool ModelComponent::canInstanceWith(const ModelComponent& other, bool programOverridden) const {
+   if (getMesh() != other.getMesh() || translucent != other.translucent) {
+      return false;
+   }
+
+   // Materials aren't applied when the program is overridden
+   return programOverridden || (getShaderProgram() == other.getShaderProgram()
+      && getGBufferShaderProgram() == other.getGBufferShaderProgram() && getMaterials() == other.getMaterials());
+}
+
+bool ModelComponent::hasBounds() const {
+   const SPtr<Mesh>& mesh = getMesh();
+   return mesh && mesh->hasLocalBounds();
+}
+
+BoundingBox ModelComponent::getWorldBoundingBox() const {
+   const SPtr<Mesh>& mesh = getMesh();
+   return mesh ? mesh->getLocalBoundingBox().transformed(getWorldMatrix()) : BoundingBox();
+}
+
+BoundingSphere ModelComponent::getWorldBoundingSphere() const {
+   const SPtr<Mesh>& mesh = getMesh();
+   return mesh ? mesh->getLocalBoundingSphere().transformed(getWorldMatrix()) : BoundingSphere();
+}
+
 SHINY_REGISTER_COMPONENT(ModelComponent)
 
 } // namespace Shiny
@@ -15,6 +15,17 @@ void PointLightComponent::apply(ShaderProgram& program, RenderData& renderData)
    }
 }
 
+void PointLightComponent::writeFrameData(FrameUniformData::Light& light) const {
+   LightComponent::writeFrameData(light);
+
+   light.color.a = static_cast<float>(FrameUniforms::kPoint);
+   light.positionFalloff.w = squareFalloff;
+}
+
+BoundingSphere PointLightComponent::getWorldBoundingSphere() const {
+   return BoundingSphere(getAbsoluteTransform().position, getFalloffRadius(squareFalloff));
+}
+
 SHINY_REGISTER_COMPONENT(PointLightComponent)
 
 } // namespace Shiny
@@ -0,0 +1,123 @@
+#include "Shiny/ShinyAssert.h"
+#include "Shiny/Graphics/Context.h"
+#include "Shiny/Graphics/Material.h"
+#include "Shiny/Graphics/RenderData.h"
+#include "Shiny/Graphics/ShaderProgram.h"
+#include "Shiny/Scene/ModelComponent.h"
+#include "Shiny/Scene/RenderCommandList.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Shiny {
+
+// static
+std::size_t RenderCommandList::getDrawDataStride() {
+   std::size_t alignment = static_cast<std::size_t>(std::max(Context::current()->getUniformBufferOffsetAlignment(), 1));
+   return (sizeof(DrawUniformData) + alignment - 1) / alignment * alignment;
+}
+
+RenderCommandList::RenderCommandList()
+   : drawDataStride(sizeof(DrawUniformData)), numDrawDataSlots(0), drawBuffer(0), drawBufferSize(0) {
+}
+
+RenderCommandList::~RenderCommandList() {
+   if (drawBuffer != 0) {
+      Context::current()->onBufferDeleted(drawBuffer);
+      glDeleteBuffers(1, &drawBuffer);
+   }
+}
+
+void RenderCommandList::reset(std::size_t newDrawDataStride) {
+   ASSERT(newDrawDataStride >= sizeof(DrawUniformData), "Draw data stride too small: %lu", newDrawDataStride);
+
+   commands.clear();
+   instances.clear();
+   drawData.clear();
+   drawDataStride = newDrawDataStride;
+   numDrawDataSlots = 0;
+}
+
+void RenderCommandList::draw(Mesh* mesh, const glm::mat4& modelMatrix, const glm::mat4& normalMatrix) {
+   std::uint32_t slot = numDrawDataSlots++;
+   drawData.resize(numDrawDataSlots * drawDataStride);
+
+   DrawUniformData data;
+   data.modelMatrix = modelMatrix;
+   data.normalMatrix = normalMatrix;
+   std::memcpy(drawData.data() + slot * drawDataStride, &data, sizeof(data));
+
+   addCommand(CommandType::kDraw, mesh, slot, 1);
+}
+
+Mesh::InstanceData* RenderCommandList::drawInstanced(Mesh* mesh, std::uint32_t numInstances) {
+   std::uint32_t firstInstance = static_cast<std::uint32_t>(instances.size());
+   instances.resize(instances.size() + numInstances);
+
+   addCommand(CommandType::kDrawInstanced, mesh, firstInstance, numInstances);
+   return &instances[firstInstance];
+}
+
+void RenderCommandList::replay(const RenderData& renderData) {
+   // All per-draw data is uploaded at once (orphaning the previous contents), then bound a range at a time
+   if (!drawData.empty()) {
+      if (drawBuffer == 0) {
+         glGenBuffers(1, &drawBuffer);
+      }
+
+      Context::current()->bindBuffer(GL_UNIFORM_BUFFER, drawBuffer);
+      if (drawData.size() > drawBufferSize) {
+         drawBufferSize = drawData.size();
+         glBufferData(GL_UNIFORM_BUFFER, drawBufferSize, drawData.data(), GL_STREAM_DRAW);
+      } else {
+         glBufferData(GL_UNIFORM_BUFFER, drawBufferSize, nullptr, GL_STREAM_DRAW);
+         glBufferSubData(GL_UNIFORM_BUFFER, 0, drawData.size(), drawData.data());
+      }
+      Context::current()->onBufferUpload(drawData.size());
+   }
+
+   ShaderProgram* program = nullptr;
+   for (const Command& command : commands) {
+      switch (command.type) {
+         case CommandType::kBindProgram:
+            program = static_cast<ShaderProgram*>(command.object);
+            break;
+         case CommandType::kApplyMaterials: {
+            ASSERT(program, "Applying materials without a program");
+
+            RenderData materialRenderData = renderData;
+            for (const SPtr<Material>& material : static_cast<ModelComponent*>(command.object)->getMaterials()) {
+               material->apply(*program, materialRenderData);
+            }
+            break;
+         }
+         case CommandType::kDraw: {
+            ASSERT(program, "Drawing without a program");
+
+            if (program->usesDrawUniformBlock()) {
+               Context::current()->bindBufferRange(GL_UNIFORM_BUFFER, DrawUniforms::kBindingPoint, drawBuffer, command.index * drawDataStride, sizeof(DrawUniformData));
+            } else if (const UniformHandle<glm::mat4>& modelMatrixUniform = program->getModelMatrixUniform()) {
+               const DrawUniformData& data = getDrawData(command.index);
+               modelMatrixUniform.set(data.modelMatrix);
+               program->getNormalMatrixUniform().set(data.normalMatrix);
+            }
+
+            program->commit();
+            static_cast<Mesh*>(command.object)->draw();
+            break;
+         }
+         case CommandType::kDrawInstanced: {
+            ASSERT(program, "Drawing without a program");
+
+            Mesh* mesh = static_cast<Mesh*>(command.object);
+            mesh->setInstanceData(&instances[command.index], command.count);
+
+            program->commit();
+            mesh->drawInstanced(command.count);
+            break;
+         }
+      }
+   }
+}
+
+} // namespace Shiny
@@ -0,0 +1,271 @@
+#include "Shiny/ShinyAssert.h"
+#include "Shiny/Graphics/Mesh.h"
+#include "Shiny/Graphics/ShaderProgram.h"
+#include "Shiny/Math/DynamicBvh.h"
+#include "Shiny/Math/Frustum.h"
+#include "Shiny/Platform/ThreadPool.h"
+#include "Shiny/Scene/CameraComponent.h"
+#include "Shiny/Scene/ModelComponent.h"
+#include "Shiny/Scene/RenderQueue.h"
+#include "Shiny/Scene/Scene.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace Shiny {
+
+namespace {
+
+const RenderQueue::SortKey kOne = 1;
+
+const int kPassShift = 61;
+const int kTranslucentShift = 60;
+
+const int kIdBits = 12;
+const std::uint32_t kIdMask = (1u << kIdBits) - 1;
+
+const int kDepthBits = 24;
+const std::uint32_t kDepthMask = (1u << kDepthBits) - 1;
+
+const int kRadixBits = 8;
+const std::size_t kRadixBuckets = 1 << kRadixBits;
+const int kRadixPasses = sizeof(RenderQueue::SortKey) * 8 / kRadixBits;
+
+std::uint32_t quantizeDepth(float viewDepth) {
+   // Anything behind the viewer (or NaN) sorts as closest
+   if (!(viewDepth > 0.0f)) {
+      return 0;
+   }
+
+   // The bit patterns of positive floats are ordered the same way as their values, so the top bits make a key that
+   // works for any depth range
+   std::uint32_t depthBits = 0;
+   std::memcpy(&depthBits, &viewDepth, sizeof(depthBits));
+
+   return depthBits >> (32 - kDepthBits);
+}
+
+std::uint32_t getMaterialId(const MaterialVector& materials) {
+   // Models sharing the exact same materials get the same id - collisions only cost some extra state changes
+   std::size_t hash = 0;
+   for (const SPtr<Material>& material : materials) {
+      hash = hash * 31 + (reinterpret_cast<std::uintptr_t>(material.get()) >> 4);
+   }
+
+   return static_cast<std::uint32_t>(hash ^ (hash >> kIdBits) ^ (hash >> (2 * kIdBits)));
+}
+
+} // namespace
+
+// static
+RenderQueue::SortKey RenderQueue::makeKey(std::uint8_t pass, bool translucent, std::uint32_t programId, std::uint32_t materialId, std::uint32_t meshId, float viewDepth) {
+   ASSERT(pass <= kMaxPass, "Render pass out of range: %u", pass);
+
+   SortKey program = programId & kIdMask;
+   SortKey material = materialId & kIdMask;
+   SortKey mesh = meshId & kIdMask;
+   SortKey depth = quantizeDepth(viewDepth);
+
+   SortKey key = static_cast<SortKey>(pass & kMaxPass) << kPassShift;
+   if (translucent) {
+      key |= kOne << kTranslucentShift;
+      key |= (kDepthMask - depth) << (3 * kIdBits);
+      key |= (program << (2 * kIdBits)) | (material << kIdBits) | mesh;
+   } else {
+      key |= (program << (kDepthBits + 2 * kIdBits)) | (material << (kDepthBits + kIdBits)) | (mesh << kDepthBits);
+      key |= depth;
+   }
+
+   return key;
+}
+
+void RenderQueue::add(ModelComponent* modelComponent, float viewDepth, std::uint8_t pass) {
+   ASSERT(modelComponent);
+
+   bool inGBuffer = modelComponent->getGBufferShaderProgram() && !modelComponent->isTranslucent();
+   if ((mode == Mode::kGBuffer && !inGBuffer) || (mode == Mode::kDeferredRemainder && inGBuffer)) {
+      return;
+   }
+
+   ShaderProgram* program = mode == Mode::kGBuffer ? modelComponent->getGBufferShaderProgram().get() : modelComponent->getShaderProgram().get();
+   Mesh* mesh = modelComponent->getMesh().get();
+   if (!program || !mesh) {
+      return;
+   }
+
+   Item item;
+   item.key = makeKey(pass, modelComponent->isTranslucent(), program->getID(), getMaterialId(modelComponent->getMaterials()), mesh->getVAO(), viewDepth);
+   item.modelComponent = modelComponent;
+
+   items.push_back(item);
+}
+
+void RenderQueue::addScene(const Scene& scene, const glm::vec3& viewPosition, const glm::vec3& viewDirection, std::uint8_t pass) {
+   const std::vector<ModelComponent*>& modelComponents = scene.getModelComponents();
+   items.reserve(items.size() + modelComponents.size());
+
+   for (ModelComponent* modelComponent : modelComponents) {
+      float viewDepth = glm::dot(modelComponent->getAbsoluteTransform().position - viewPosition, viewDirection);
+      add(modelComponent, viewDepth, pass);
+   }
+}
+
+void RenderQueue::addScene(const Scene& scene, const CameraComponent& camera, std::uint8_t pass) {
+   glm::vec3 viewPosition = camera.getAbsoluteTransform().position;
+   glm::vec3 viewDirection = camera.getFront();
+
+   // Whole subtrees of the spatial index are culled (or accepted) at once, so this scales with what's visible rather
+   // than with the size of the scene
+   Frustum frustum = camera.getFrustum();
+   const DynamicBvh& spatialIndex = scene.getModelSpatialIndex();
+   candidateModelComponents.clear();
+   candidateSpheres.clear();
+   spatialIndex.query(frustum, [this, &spatialIndex](DynamicBvh::ProxyId proxyId) {
+      ModelComponent* modelComponent = static_cast<ModelComponent*>(spatialIndex.getUserData(proxyId));
+      candidateModelComponents.push_back(modelComponent);
+      candidateSpheres.push_back(modelComponent->getWorldBoundingSphere());
+      return true;
+   });
+
+   // The fat boxes are padded, so the candidates are tested again with their tight spheres (several at a time)
+   visibleCandidates.resize(candidateSpheres.size());
+   std::size_t numVisible = frustum.cullSpheres(candidateSpheres.data(), candidateSpheres.size(), visibleCandidates.data());
+   items.reserve(items.size() + numVisible);
+   for (std::size_t i = 0; i < numVisible; ++i) {
+      std::uint32_t candidate = visibleCandidates[i];
+      add(candidateModelComponents[candidate], glm::dot(candidateSpheres[candidate].center - viewPosition, viewDirection), pass);
+   }
+
+   for (ModelComponent* modelComponent : scene.getUnboundedModelComponents()) {
+      add(modelComponent, glm::dot(modelComponent->getAbsoluteTransform().position - viewPosition, viewDirection), pass);
+   }
+}
+
+void RenderQueue::sort() {
+   std::size_t count = items.size();
+   if (count < 2) {
+      return;
+   }
+
+   // Histogram every digit in a single pass over the keys
+   std::array<std::array<std::size_t, kRadixBuckets>, kRadixPasses> histograms {};
+   for (const Item& item : items) {
+      for (int radixPass = 0; radixPass < kRadixPasses; ++radixPass) {
+         ++histograms[radixPass][(item.key >> (radixPass * kRadixBits)) & (kRadixBuckets - 1)];
+      }
+   }
+
+   scratchItems.resize(count);
+   for (int radixPass = 0; radixPass < kRadixPasses; ++radixPass) {
+      std::array<std::size_t, kRadixBuckets>& histogram = histograms[radixPass];
+      int shift = radixPass * kRadixBits;
+
+      // Digits shared by every key don't change the order (common for the pass and translucency bits)
+      if (histogram[(items[0].key >> shift) & (kRadixBuckets - 1)] == count) {
+         continue;
+      }
+
+      std::size_t offset = 0;
+      for (std::size_t& bucket : histogram) {
+         std::size_t bucketCount = bucket;
+         bucket = offset;
+         offset += bucketCount;
+      }
+
+      for (const Item& item : items) {
+         scratchItems[histogram[(item.key >> shift) & (kRadixBuckets - 1)]++] = item;
+      }
+
+      items.swap(scratchItems);
+   }
+}
+
+void RenderQueue::submit(const RenderData& queueRenderData, ThreadPool* threadPool) {
+   RenderData renderData = queueRenderData;
+   renderData.setGBufferPass(mode == Mode::kGBuffer);
+
+   // One slice per participating thread, unless there are too few draws to be worth splitting
+   std::size_t count = items.size();
+   std::size_t numSlices = 1;
+   if (threadPool) {
+      numSlices = std::max(std::min(threadPool->getNumThreads() + 1, count / kMinDrawsPerSlice), std::size_t(1));
+   }
+
+   while (commandLists.size() < numSlices) {
+      commandLists.push_back(std::make_unique<RenderCommandList>());
+   }
+
+   // Recording only reads the world matrices, so anything changed since the last Scene::updateTransforms() is brought up
+   // to date here, before any worker can see it
+   for (const Item& item : items) {
+      item.modelComponent->updateWorldData();
+   }
+
+   std::size_t drawDataStride = RenderCommandList::getDrawDataStride();
+   auto recordSlices = [this, &renderData, count, numSlices, drawDataStride](std::size_t beginSlice, std::size_t endSlice) {
+      for (std::size_t slice = beginSlice; slice < endSlice; ++slice) {
+         RenderCommandList& commandList = *commandLists[slice];
+         commandList.reset(drawDataStride);
+         record(commandList, renderData, count * slice / numSlices, count * (slice + 1) / numSlices);
+      }
+   };
+
+   if (numSlices > 1) {
+      threadPool->parallelFor(numSlices, 1, recordSlices);
+   } else {
+      recordSlices(0, 1);
+   }
+
+   // GL calls are only made here, in slice (and so key) order
+   for (std::size_t slice = 0; slice < numSlices; ++slice) {
+      commandLists[slice]->replay(renderData);
+   }
+}
+
+void RenderQueue::record(RenderCommandList& commandList, const RenderData& renderData, std::size_t begin, std::size_t end) const {
+   bool programOverridden = renderData.getOverrideProgram() != nullptr;
+
+   // Programs, VAOs and textures are only rebound by the context when they change, which is rare in key order.
+   // Materials are only applied again when the program or materials change.
+   ShaderProgram* boundProgram = nullptr;
+   const MaterialVector* appliedMaterials = nullptr;
+   for (std::size_t first = begin; first < end;) {
+      ModelComponent* modelComponent = items[first].modelComponent;
+      ShaderProgram* program = modelComponent->selectShaderProgram(renderData);
+      Mesh* mesh = modelComponent->getMesh().get();
+
+      if (program != boundProgram) {
+         commandList.bindProgram(program);
+         boundProgram = program;
+         appliedMaterials = nullptr;
+      }
+
+      if (!programOverridden && (!appliedMaterials || *appliedMaterials != modelComponent->getMaterials())) {
+         commandList.applyMaterials(modelComponent);
+         appliedMaterials = &modelComponent->getMaterials();
+      }
+
+      if (!program->supportsInstancing()) {
+         commandList.draw(mesh, modelComponent->getCachedWorldMatrix(), modelComponent->getCachedNormalMatrix());
+         ++first;
+         continue;
+      }
+
+      // Matching draws are adjacent in key order, so each run becomes a single instanced draw
+      std::size_t last = first + 1;
+      while (last < end && last - first < kMaxInstancesPerDraw && modelComponent->canInstanceWith(*items[last].modelComponent, programOverridden)) {
+         ++last;
+      }
+
+      Mesh::InstanceData* instances = commandList.drawInstanced(mesh, static_cast<std::uint32_t>(last - first));
+      for (std::size_t i = first; i < last; ++i) {
+         instances[i - first].modelMatrix = items[i].modelComponent->getCachedWorldMatrix();
+         instances[i - first].normalMatrix = items[i].modelComponent->getCachedNormalMatrix();
+      }
+
+      first = last;
+   }
+}
+
+} // namespace Shiny
@@ -1,61 +1,417 @@
+#include "Shiny/Entity/Prefab.h"
+#include "Shiny/Scene/CameraComponent.h"
 #include "Shiny/Scene/LightComponent.h"
 #include "Shiny/Scene/ModelComponent.h"
 #include "Shiny/Scene/Scene.h"
+#include "Shiny/Scene/SceneCommandBuffer.h"
+
+#include <cmath>
 
 namespace Shiny {
 
-void Scene::registerModelComponent(ModelComponent* modelComponent) {
-   auto addToMap = [this](ModelComponent* modelComponent, ShaderProgram* newProgram) {
-      auto pair = modelComponentsByShaderProgram.emplace(newProgram, std::vector<ModelComponent*>());
-      pair.first->second.push_back(modelComponent);
-   };
+Scene::Scene()
+   : commandBuffer(new SceneCommandBuffer), queryListHead(nullptr), activeCamera(nullptr) {
+}
+
+Scene::~Scene() {
+   while (!entities.empty()) {
+      destroyEntity(entities.back()->getHandle());
+   }
+}
+
+bool Scene::destroyEntity(EntityHandle handle) {
+   Entity* entity = getEntity(handle);
+   if (!entity) {
+      return false;
+   }
+
+   // Invalidate the handle up front, so that destroy callbacks can't destroy the same entity again
+   EntitySlot& slot = entitySlots[handle.index];
+   if (++slot.generation == 0) {
+      slot.generation = 1;
+   }
+
+   entity->executeDestroy();
+
+   for (UPtr<QueryNode>& queryNode : queryNodes) {
+      queryNode->query.remove(*entity);
+   }
+
+   // Destroy callbacks may have created or destroyed other entities, so look up the dense index again
+   std::uint32_t denseIndex = entitySlots[handle.index].denseIndex;
+   UPtr<Entity> destroyedEntity = std::move(entities[denseIndex]);
+
+   if (denseIndex + 1 != entities.size()) {
+      entities[denseIndex] = std::move(entities.back());
+      entitySlots[entities[denseIndex]->getHandle().index].denseIndex = denseIndex;
+   }
+   entities.pop_back();
+
+   entitySlots[handle.index].denseIndex = EntityHandle::kInvalidIndex;
+   freeEntitySlots.push_back(handle.index);
+
+   return true;
+}
 
-   auto removeFromMap = [this](ModelComponent* modelComponent) {
-      ShaderProgram* oldProgram = modelComponent->getShaderProgram().get();
+void Scene::instantiate(const Prefab& prefab, std::size_t count, const InstantiateFunc& initFunction) {
+   if (count == 0) {
+      return;
+   }
 
-      auto mapItr = modelComponentsByShaderProgram.find(oldProgram);
-      ASSERT(mapItr != modelComponentsByShaderProgram.end());
+   reserveAdditionalEntities(count);
 
-      auto vecItr = std::find(mapItr->second.begin(), mapItr->second.end(), modelComponent);
-      ASSERT(vecItr != mapItr->second.end());
+   std::vector<Entity*> newEntities;
+   newEntities.reserve(count);
+   for (std::size_t i = 0; i < count; ++i) {
+      EntityHandle handle = allocateEntitySlot();
+      newEntities.push_back(new Entity(*this, componentStore, handle));
 
-      mapItr->second.erase(vecItr);
-      if (mapItr->second.empty()) {
-         modelComponentsByShaderProgram.erase(mapItr);
+      entitySlots[handle.index].denseIndex = static_cast<std::uint32_t>(entities.size());
+      entities.push_back(UPtr<Entity>(newEntities.back()));
+   }
+
+   // Construct one component type at a time, so each storage is reserved once and filled contiguously
+   for (const Prefab::ComponentEntry& componentEntry : prefab.components) {
+      ComponentStorageBase& storage = componentStore.getStorage(componentEntry.typeId, componentEntry.createStorageFunc);
+      storage.reserve(count);
+
+      for (Entity* entity : newEntities) {
+         Component* component = entity->constructComponent(storage);
+         if (componentEntry.initFunction) {
+            componentEntry.initFunction(*component);
+         }
       }
-   };
+   }
 
-   ModelComponentHandles handles;
-   handles.onDestroyHandle = modelComponent->bindOnDestroy([this, removeFromMap](Component* component) {
-      ModelComponent* modelComponent = static_cast<ModelComponent*>(component);
-      removeFromMap(modelComponent);
-      modelComponentHandles.erase(modelComponent);
+   for (Entity* entity : newEntities) {
+      entity->tags = prefab.getTags();
+      entity->onInitialized();
+   }
+
+   for (std::size_t i = 0; i < count; ++i) {
+      updateViews(*newEntities[i]);
+
+      if (initFunction) {
+         initFunction(*newEntities[i], i);
+      }
+   }
+}
+
+void Scene::flushCommands(SceneCommandBuffer& buffer) {
+   SceneCommandBuffer::Commands commands;
+   buffer.takeCommands(commands);
+
+   for (EntityHandle handle : commands.destroys) {
+      destroyEntity(handle);
+   }
+
+   for (const SceneCommandBuffer::RemoveComponentCommand& command : commands.removes) {
+      if (Entity* entity = getEntity(command.handle)) {
+         command.destroyFunction(*entity);
+      }
+   }
+
+   for (const SceneCommandBuffer::AddComponentCommand& command : commands.adds) {
+      Entity* entity = getEntity(command.handle);
+      if (!entity) {
+         continue;
+      }
+
+      Component* component = command.createFunction ? command.createFunction(*entity) : entity->createComponentByName(command.className);
+      if (component && command.initFunction) {
+         command.initFunction(*component);
+      }
+   }
+
+   reserveAdditionalEntities(commands.spawns.size());
+   for (const SceneCommandBuffer::SpawnCommand& command : commands.spawns) {
+      Entity* entity = command.createFunction ? command.createFunction(*this) : createEntity(command.componentClassNames);
+      if (command.initFunction) {
+         command.initFunction(*entity);
+      }
+   }
+}
+
+void Scene::reserveAdditionalEntities(std::size_t additionalCount) {
+   // Grow geometrically, so that spawning a few entities every frame doesn't reallocate every frame
+   std::size_t requiredCapacity = entities.size() + additionalCount;
+   if (requiredCapacity > entities.capacity()) {
+      reserveEntities(std::max(requiredCapacity, entities.capacity() * 2));
+   }
+}
+
+EntityHandle Scene::allocateEntitySlot() {
+   std::uint32_t index = 0;
+   if (!freeEntitySlots.empty()) {
+      index = freeEntitySlots.back();
+      freeEntitySlots.pop_back();
+   } else {
+      ASSERT(entitySlots.size() < EntityHandle::kInvalidIndex, "Too many entities");
+
+      index = static_cast<std::uint32_t>(entitySlots.size());
+      entitySlots.emplace_back();
+   }
+
+   return EntityHandle(index, entitySlots[index].generation);
+}
+
+Entity* Scene::addEntity(UPtr<Entity> entity) {
+   ASSERT(entity);
+
+   entitySlots[entity->getHandle().index].denseIndex = static_cast<std::uint32_t>(entities.size());
+   entities.push_back(std::move(entity));
+
+   Entity* newEntity = entities.back().get();
+   updateViews(*newEntity);
+
+   return newEntity;
+}
+
+EntityQuery& Scene::getQuery(const ViewFilter& filter) {
+   if (EntityQuery* query = findQuery(filter)) {
+      return *query;
+   }
+
+   std::lock_guard<std::mutex> lock(queryMutex);
+
+   // Another system may have created the query while this one was waiting for the lock
+   if (EntityQuery* query = findQuery(filter)) {
+      return *query;
+   }
+
+   // Entities only change at the frame's sync point, so they can be read while systems run
+   UPtr<QueryNode> queryNode(new QueryNode(filter, queryListHead.load(std::memory_order_relaxed)));
+   for (UPtr<Entity>& entity : entities) {
+      queryNode->query.update(*entity);
+   }
+
+   queryListHead.store(queryNode.get(), std::memory_order_release);
+   queryNodes.push_back(std::move(queryNode));
+
+   return queryNodes.back()->query;
+}
+
+EntityQuery* Scene::findQuery(const ViewFilter& filter) const {
+   // Scenes only ever use a handful of distinct filters, so a linear search is fine
+   for (QueryNode* queryNode = queryListHead.load(std::memory_order_acquire); queryNode; queryNode = queryNode->next) {
+      if (queryNode->query.getFilter() == filter) {
+         return &queryNode->query;
+      }
+   }
+
+   return nullptr;
+}
+
+void Scene::updateViews(Entity& entity) {
+   // Entities that are still being constructed or destroyed are added / removed by the scene itself
+   if (getEntity(entity.getHandle()) != &entity) {
+      return;
+   }
+
+   // Only called at the sync point (structural changes from systems are deferred), so no queries are being added
+   for (UPtr<QueryNode>& queryNode : queryNodes) {
+      queryNode->query.update(entity);
+   }
+}
+
+void Scene::updateSpatialIndices() {
+   // Only models that moved (or got bounds) since the last update touch the tree
+   for (ModelComponent* modelComponent : pendingSpatialModelComponents) {
+      modelComponent->spatialUpdatePending = false;
+
+      if (modelComponent->unboundedIndex != ModelComponent::kNotUnbounded) {
+         continue;
+      }
+
+      if (modelComponent->spatialProxyId == DynamicBvh::kNullProxy) {
+         modelComponent->spatialProxyId = modelSpatialIndex.createProxy(modelComponent->getWorldBoundingBox(), modelComponent);
+      } else {
+         modelSpatialIndex.moveProxy(modelComponent->spatialProxyId, modelComponent->getWorldBoundingBox());
+      }
+   }
+   pendingSpatialModelComponents.clear();
+
+   for (LightComponent* lightComponent : lightComponents) {
+      auto itr = lightComponentEntries.find(lightComponent);
+      ASSERT(itr != lightComponentEntries.end());
+      LightComponentEntry& entry = itr->second;
+
+      // Ranges can change without the light moving, so every light is checked (lights are few, and moving within the fat
+      // box is cheap)
+      BoundingSphere sphere = lightComponent->getWorldBoundingSphere();
+      if (std::isinf(sphere.radius)) {
+         // Lights that affect everything can't be culled, so they stay out of the tree
+         if (entry.proxyId != DynamicBvh::kNullProxy) {
+            lightSpatialIndex.destroyProxy(entry.proxyId);
+            entry.proxyId = DynamicBvh::kNullProxy;
+         }
+      } else {
+         BoundingBox box(sphere.center - glm::vec3(sphere.radius), sphere.center + glm::vec3(sphere.radius));
+         if (entry.proxyId == DynamicBvh::kNullProxy) {
+            entry.proxyId = lightSpatialIndex.createProxy(box, lightComponent);
+         } else {
+            lightSpatialIndex.moveProxy(entry.proxyId, box);
+         }
+      }
+   }
+
+   modelSpatialIndex.rebuildIfNeeded();
+   lightSpatialIndex.rebuildIfNeeded();
+}
+
+void Scene::updateFrameUniforms() {
+   if (activeCamera) {
+      frameUniformData.viewMatrix = activeCamera->getViewMatrix();
+      frameUniformData.projMatrix = activeCamera->getProjectionMatrix();
+      frameUniformData.cameraPosition = glm::vec4(activeCamera->getAbsoluteTransform().position, 1.0f);
+   } else {
+      frameUniformData.viewMatrix = glm::mat4(1.0f);
+      frameUniformData.projMatrix = glm::mat4(1.0f);
+      frameUniformData.cameraPosition = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+   }
+   frameUniformData.viewProjMatrix = frameUniformData.projMatrix * frameUniformData.viewMatrix;
+
+   // Lights that affect everything first (classified the same way as in updateSpatialIndices(), so that lights
+   // registered since then are judged by their range rather than by not having a proxy yet)
+   int numLights = 0;
+   for (LightComponent* lightComponent : lightComponents) {
+      if (numLights < FrameUniforms::kMaxLights && std::isinf(lightComponent->getWorldBoundingSphere().radius)) {
+         lightComponent->writeFrameData(frameUniformData.lights[numLights++]);
+      }
+   }
+
+   Frustum frustum = activeCamera ? activeCamera->getFrustum() : Frustum();
+   lightSpatialIndex.query(frustum, [this, &numLights](DynamicBvh::ProxyId proxyId) {
+      if (numLights >= FrameUniforms::kMaxLights) {
+         return false;
+      }
+
+      static_cast<LightComponent*>(lightSpatialIndex.getUserData(proxyId))->writeFrameData(frameUniformData.lights[numLights++]);
+      return true;
    });
-   handles.onShaderProgramChangeHandle = modelComponent->bindOnShaderProgramChange(
-      [this, removeFromMap, addToMap](ModelComponent* modelComponent, ShaderProgram* newProgram) {
-      removeFromMap(modelComponent);
-      addToMap(modelComponent, newProgram);
+
+   frameUniformData.numLights = glm::ivec4(numLights, 0, 0, 0);
+
+   if (!frameUniformBuffer) {
+      frameUniformBuffer = std::make_unique<FrameUniformBuffer>();
+   }
+   frameUniformBuffer->upload(frameUniformData);
+}
+
+void Scene::onModelBoundsChanged(ModelComponent* modelComponent) {
+   if (!modelComponent->spatiallyTracked) {
+      return;
+   }
+
+   bool unbounded = modelComponent->unboundedIndex != ModelComponent::kNotUnbounded;
+
+   if (!modelComponent->hasBounds()) {
+      if (modelComponent->spatialProxyId != DynamicBvh::kNullProxy) {
+         modelSpatialIndex.destroyProxy(modelComponent->spatialProxyId);
+         modelComponent->spatialProxyId = DynamicBvh::kNullProxy;
+      }
+
+      if (!unbounded) {
+         modelComponent->unboundedIndex = unboundedModelComponents.size();
+         unboundedModelComponents.push_back(modelComponent);
+      }
+
+      return;
+   }
+
+   if (unbounded) {
+      removeUnboundedModelComponent(modelComponent);
+   }
+
+   // The proxy is created (or resized for the new mesh) by the next update
+   onModelMoved(modelComponent);
+}
+
+void Scene::removeUnboundedModelComponent(ModelComponent* modelComponent) {
+   // Swap with the last unbounded model component
+   ModelComponent* lastModelComponent = unboundedModelComponents.back();
+   unboundedModelComponents[modelComponent->unboundedIndex] = lastModelComponent;
+   lastModelComponent->unboundedIndex = modelComponent->unboundedIndex;
+   unboundedModelComponents.pop_back();
+
+   modelComponent->unboundedIndex = ModelComponent::kNotUnbounded;
+}
+
+void Scene::onModelMoved(ModelComponent* modelComponent) {
+   if (!modelComponent->spatiallyTracked) {
+      return;
+   }
+
+   std::lock_guard<std::mutex> lock(pendingSpatialMutex);
+
+   if (!modelComponent->spatialUpdatePending) {
+      modelComponent->spatialUpdatePending = true;
+      pendingSpatialModelComponents.push_back(modelComponent);
+   }
+}
+
+void Scene::registerModelComponent(ModelComponent* modelComponent) {
+   ModelComponentEntry entry;
+   entry.index = modelComponents.size();
+   entry.onDestroyHandle = modelComponent->bindOnDestroy([this](Component* component) {
+      ModelComponent* modelComponent = static_cast<ModelComponent*>(component);
+
+      auto itr = modelComponentEntries.find(modelComponent);
+      ASSERT(itr != modelComponentEntries.end());
+
+      modelComponent->spatiallyTracked = false;
+      if (modelComponent->spatialProxyId != DynamicBvh::kNullProxy) {
+         modelSpatialIndex.destroyProxy(modelComponent->spatialProxyId);
+         modelComponent->spatialProxyId = DynamicBvh::kNullProxy;
+      } else if (modelComponent->unboundedIndex != ModelComponent::kNotUnbounded) {
+         removeUnboundedModelComponent(modelComponent);
+      }
+
+      if (modelComponent->spatialUpdatePending) {
+         std::lock_guard<std::mutex> lock(pendingSpatialMutex);
+         pendingSpatialModelComponents.erase(std::find(pendingSpatialModelComponents.begin(), pendingSpatialModelComponents.end(), modelComponent));
+      }
+
+      // Swap with the last model component
+      std::size_t index = itr->second.index;
+      ModelComponent* lastModelComponent = modelComponents.back();
+      modelComponents[index] = lastModelComponent;
+      modelComponentEntries[lastModelComponent].index = index;
+      modelComponents.pop_back();
+
+      modelComponentEntries.erase(itr);
    });
 
-   modelComponentHandles[modelComponent] = std::move(handles);
-   addToMap(modelComponent, modelComponent->getShaderProgram().get());
+   modelComponents.push_back(modelComponent);
+   modelComponentEntries[modelComponent] = std::move(entry);
+
+   modelComponent->spatiallyTracked = true;
+   onModelBoundsChanged(modelComponent);
 }
 
 void Scene::registerLightComponent(LightComponent* lightComponent) {
-   lightComponents.push_back(lightComponent);
-
-   lightComponentDestroyHandles[lightComponent] = lightComponent->bindOnDestroy([this](Component* component) {
-      LightComponent* lightComponent = static_cast<LightComponent*>(component);
+   LightComponentEntry entry;
+   entry.index = lightComponents.size();
+   entry.onDestroyHandle = lightComponent->bindOnDestroy([this](Component* component) {
+      auto itr = lightComponentEntries.find(static_cast<LightComponent*>(component));
+      ASSERT(itr != lightComponentEntries.end());
 
-      auto vecItr = std::find(lightComponents.begin(), lightComponents.end(), lightComponent);
-      ASSERT(vecItr != lightComponents.end());
+      if (itr->second.proxyId != DynamicBvh::kNullProxy) {
+         lightSpatialIndex.destroyProxy(itr->second.proxyId);
+      }
 
-      auto mapItr = lightComponentDestroyHandles.find(lightComponent);
-      ASSERT(mapItr != lightComponentDestroyHandles.end());
+      // Swap with the last light component
+      std::size_t index = itr->second.index;
+      LightComponent* lastLightComponent = lightComponents.back();
+      lightComponents[index] = lastLightComponent;
+      lightComponentEntries[lastLightComponent].index = index;
+      lightComponents.pop_back();
 
-      lightComponents.erase(vecItr);
-      lightComponentDestroyHandles.erase(mapItr);
+      lightComponentEntries.erase(itr);
    });
+
+   lightComponents.push_back(lightComponent);
+   lightComponentEntries[lightComponent] = std::move(entry);
 }
 
 } // namespace Shiny
@@ -0,0 +1,462 @@
+#include "Shiny/Log.h"
+#include "Shiny/ShinyAssert.h"
+#include "Shiny/Graphics/Context.h"
+#include "Shiny/Graphics/FrameUniforms.h"
+#include "Shiny/Graphics/Framebuffer.h"
+#include "Shiny/Graphics/GpuProfiler.h"
+#include "Shiny/Graphics/Mesh.h"
+#include "Shiny/Graphics/RenderData.h"
+#include "Shiny/Graphics/Shader.h"
+#include "Shiny/Graphics/Texture.h"
+#include "Shiny/Math/DynamicBvh.h"
+#include "Shiny/Math/Transform.h"
+#include "Shiny/Scene/CameraComponent.h"
+#include "Shiny/Scene/LightComponent.h"
+#include "Shiny/Scene/Scene.h"
+#include "Shiny/Scene/SceneRenderer.h"
+
+#include <glm/gtc/constants.hpp>
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#if defined(GLSL)
+#  undef GLSL
+#endif
+#define GLSL(source) "#version 330 core\n" #source
+
+namespace Shiny {
+
+namespace {
+
+const std::vector<Tex::InternalFormat> kGBufferFormats = {
+   Tex::InternalFormat::kRGBA8,   // SceneRenderer::kAlbedo
+   Tex::InternalFormat::kRGBA16F, // SceneRenderer::kNormal
+   Tex::InternalFormat::kRGBA8    // SceneRenderer::kMaterial
+};
+
+const int kVolumeSegments = 16;
+const int kSphereRings = 8;
+
+// Wider spot lights are drawn with a sphere, which covers less of the screen than their cone would
+const float kMaxConeVolumeAngle = glm::radians(60.0f);
+
+const char* kLightingVertexSource = GLSL(
+   uniform mat4 uTransform;
+
+   in vec3 aPosition;
+
+   void main() {
+      gl_Position = uTransform * vec4(aPosition, 1.0);
+   }
+);
+
+const char* kLightingFragmentSource = GLSL(
+   struct ShinyLight {
+      vec4 color;
+      vec4 positionFalloff;
+      vec4 directionBeam;
+      vec4 cutoff;
+   };
+
+   layout(std140) uniform ShinyFrame {
+      mat4 uViewMatrix;
+      mat4 uProjMatrix;
+      mat4 uViewProjMatrix;
+      vec4 uCameraPosition;
+      ivec4 uNumLights;
+      ShinyLight uLights[SHINY_MAX_LIGHTS];
+   };
+
+   uniform sampler2D uGBufferAlbedo;
+   uniform sampler2D uGBufferNormal;
+   uniform sampler2D uGBufferMaterial;
+   uniform sampler2D uGBufferDepth;
+
+   uniform mat4 uInverseViewProjMatrix;
+   uniform bool uLightVolume;
+   uniform ShinyLight uLight;
+
+   out vec4 color;
+
+   const float kMinIntensity = 1.0 / 256.0;
+
+   vec3 shade(ShinyLight light, vec3 position, vec3 normal, vec3 albedo, vec3 specular, float shininess) {
+      int type = int(light.color.a);
+      if (type == 0) {
+         return light.color.rgb * albedo;
+      }
+
+      vec3 toLight = -light.directionBeam.xyz;
+      float intensity = 1.0;
+      if (type != 1) {
+         toLight = light.positionFalloff.xyz - position;
+         float distance = length(toLight);
+         toLight /= distance;
+
+         // Reaches zero at the light's range (see LightComponent::getFalloffRadius()), so volume edges don't show
+         float attenuation = 1.0 / (1.0 + light.positionFalloff.w * distance * distance);
+         intensity = max((attenuation - kMinIntensity) / (1.0 - kMinIntensity), 0.0);
+
+         if (type == 3) {
+            intensity *= smoothstep(cos(light.cutoff.x), cos(light.directionBeam.w), dot(-toLight, light.directionBeam.xyz));
+         }
+      }
+
+      vec3 halfway = normalize(toLight + normalize(uCameraPosition.xyz - position));
+      float diffuseAmount = max(dot(normal, toLight), 0.0);
+      float specularAmount = diffuseAmount > 0.0 ? pow(max(dot(normal, halfway), 0.0), shininess) : 0.0;
+
+      return light.color.rgb * intensity * (albedo * diffuseAmount + specular * specularAmount);
+   }
+
+   void main() {
+      ivec2 texel = ivec2(gl_FragCoord.xy);
+
+      // Nothing was drawn to the G-buffer here
+      float depth = texelFetch(uGBufferDepth, texel, 0).r;
+      if (depth >= 1.0) {
+         discard;
+      }
+
+      vec2 texCoord = gl_FragCoord.xy / vec2(textureSize(uGBufferDepth, 0));
+      vec4 worldPosition = uInverseViewProjMatrix * vec4(vec3(texCoord, depth) * 2.0 - 1.0, 1.0);
+      vec3 position = worldPosition.xyz / worldPosition.w;
+
+      vec4 albedo = texelFetch(uGBufferAlbedo, texel, 0);
+      vec4 normalShininess = texelFetch(uGBufferNormal, texel, 0);
+      vec3 normal = normalize(normalShininess.xyz);
+      vec3 specular = texelFetch(uGBufferMaterial, texel, 0).rgb;
+
+      if (uLightVolume) {
+         color = vec4(shade(uLight, position, normal, albedo.rgb, specular, normalShininess.w), 1.0);
+         return;
+      }
+
+      vec3 lighting = albedo.rgb * albedo.a;
+      for (int i = 0; i < uNumLights.x; ++i) {
+         // Point and spot lights are drawn as volumes, unless they have no falloff (and so no bounded volume - they are
+         // kept out of the light spatial index, see LightComponent::getFalloffRadius())
+         if (int(uLights[i].color.a) <= 1 || uLights[i].positionFalloff.w <= 0.0) {
+            lighting += shade(uLights[i], position, normal, albedo.rgb, specular, normalShininess.w);
+         }
+      }
+
+      color = vec4(lighting, 1.0);
+   }
+);
+
+// The lighting shader's copy of the ShinyFrame block has to match the std140 layout of FrameUniformData, so its light
+// count comes from FrameUniforms::kMaxLights (defined after the #version line)
+std::string getLightingFragmentSource() {
+   std::string source = kLightingFragmentSource;
+   source.insert(source.find('\n') + 1, "#define SHINY_MAX_LIGHTS " + std::to_string(FrameUniforms::kMaxLights) + "\n");
+
+   return source;
+}
+
+SPtr<Shader> compileShader(GLenum type, const char* source) {
+   SPtr<Shader> shader = std::make_shared<Shader>(type);
+   if (!shader->compile(source)) {
+      LOG_ERROR("Unable to compile deferred lighting shader");
+   }
+
+   return shader;
+}
+
+UPtr<Mesh> createMesh(const std::vector<float>& vertices, const std::vector<unsigned int>& indices) {
+   return std::make_unique<Mesh>(vertices.data(), static_cast<unsigned int>(vertices.size() / 3), nullptr, 0, nullptr, 0,
+                                 indices.data(), static_cast<unsigned int>(indices.size()));
+}
+
+UPtr<Mesh> createFullscreenMesh() {
+   // A single triangle covering the whole screen
+   return createMesh({ -1.0f, -1.0f, 0.0f,
+                        3.0f, -1.0f, 0.0f,
+                       -1.0f,  3.0f, 0.0f }, { 0, 1, 2 });
+}
+
+UPtr<Mesh> createSphereMesh() {
+   // Flat faces cut inside the unit sphere, so the vertices are pushed out until the faces contain it
+   float scale = 1.0f / (std::cos(glm::pi<float>() / kVolumeSegments) * std::cos(glm::half_pi<float>() / kSphereRings));
+
+   std::vector<float> vertices;
+   for (int ring = 0; ring <= kSphereRings; ++ring) {
+      float theta = glm::pi<float>() * ring / kSphereRings;
+      for (int segment = 0; segment < kVolumeSegments; ++segment) {
+         float phi = glm::two_pi<float>() * segment / kVolumeSegments;
+
+         vertices.push_back(scale * std::sin(theta) * std::cos(phi));
+         vertices.push_back(scale * std::cos(theta));
+         vertices.push_back(scale * -std::sin(theta) * std::sin(phi));
+      }
+   }
+
+   // Counter-clockwise when seen from outside
+   std::vector<unsigned int> indices;
+   for (int ring = 0; ring < kSphereRings; ++ring) {
+      for (int segment = 0; segment < kVolumeSegments; ++segment) {
+         unsigned int topLeft = ring * kVolumeSegments + segment;
+         unsigned int topRight = ring * kVolumeSegments + (segment + 1) % kVolumeSegments;
+         unsigned int bottomLeft = topLeft + kVolumeSegments;
+         unsigned int bottomRight = topRight + kVolumeSegments;
+
+         indices.insert(indices.end(), { topLeft, bottomLeft, bottomRight, topLeft, bottomRight, topRight });
+      }
+   }
+
+   return createMesh(vertices, indices);
+}
+
+UPtr<Mesh> createConeMesh() {
+   // Apex at the origin, opening along -z to a base of radius 1 at z = -1 (pushed out to contain the circular base)
+   float scale = 1.0f / std::cos(glm::pi<float>() / kVolumeSegments);
+
+   std::vector<float> vertices = { 0.0f, 0.0f, 0.0f,
+                                   0.0f, 0.0f, -1.0f };
+   for (int segment = 0; segment < kVolumeSegments; ++segment) {
+      float phi = glm::two_pi<float>() * segment / kVolumeSegments;
+
+      vertices.push_back(scale * std::cos(phi));
+      vertices.push_back(scale * std::sin(phi));
+      vertices.push_back(-1.0f);
+   }
+
+   // Counter-clockwise when seen from outside
+   std::vector<unsigned int> indices;
+   for (int segment = 0; segment < kVolumeSegments; ++segment) {
+      unsigned int current = 2 + segment;
+      unsigned int next = 2 + (segment + 1) % kVolumeSegments;
+
+      indices.insert(indices.end(), { 0, current, next, 1, next, current });
+   }
+
+   return createMesh(vertices, indices);
+}
+
+void bindTarget(Framebuffer* target) {
+   if (target) {
+      target->bind();
+   } else {
+      Framebuffer::bindDefaultFramebuffer();
+   }
+}
+
+} // namespace
+
+SceneRenderer::SceneRenderer()
+   : threadPool(nullptr), forwardQueue(RenderQueue::Mode::kForward), gBufferQueue(RenderQueue::Mode::kGBuffer),
+     remainderQueue(RenderQueue::Mode::kDeferredRemainder) {
+}
+
+SceneRenderer::~SceneRenderer() {
+}
+
+void SceneRenderer::render(Scene& scene, RenderPath path, Framebuffer* target) {
+   CameraComponent* camera = scene.getActiveCamera();
+   if (!camera) {
+      return;
+   }
+
+   // Used by the models' programs in both paths, and by the deferred lighting
+   scene.updateFrameUniforms();
+
+   if (path == RenderPath::kDeferred) {
+      renderDeferred(scene, *camera, target);
+   } else {
+      renderForward(scene, *camera, target);
+   }
+}
+
+void SceneRenderer::renderForward(Scene& scene, const CameraComponent& camera, Framebuffer* target) {
+   SHINY_GPU_SCOPE("Forward");
+
+   bindTarget(target);
+
+   forwardQueue.clear();
+   forwardQueue.addScene(scene, camera);
+   forwardQueue.sort();
+   forwardQueue.submit(RenderData(), threadPool);
+}
+
+void SceneRenderer::renderDeferred(Scene& scene, const CameraComponent& camera, Framebuffer* target) {
+   Viewport viewport = Context::current()->getViewport();
+   GLsizei width = target ? target->getWidth() : viewport.width;
+   GLsizei height = target ? target->getHeight() : viewport.height;
+
+   prepareGBuffer(width, height);
+
+   {
+      SHINY_GPU_SCOPE("G-buffer");
+
+      // Every pixel of the G-buffer that is drawn to is written by the geometry, so only depth needs to be cleared
+      gBuffer->bind();
+      glClear(GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+      gBufferQueue.clear();
+      gBufferQueue.addScene(scene, camera);
+      gBufferQueue.sort();
+      gBufferQueue.submit(RenderData(), threadPool);
+   }
+
+   // The lighting and remaining forward draws are depth tested against the G-buffer's depth
+   bool targetHasDepth = !target || target->hasDepthStencilAttachment();
+   {
+      SHINY_GPU_SCOPE("Lighting");
+
+      if (targetHasDepth) {
+         Context::current()->bindReadFramebuffer(gBuffer->getId());
+         Context::current()->bindDrawFramebuffer(target ? target->getId() : 0);
+         glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT, GL_NEAREST);
+      }
+
+      bindTarget(target);
+      renderLighting(scene, camera, targetHasDepth);
+   }
+
+   SHINY_GPU_SCOPE("Forward");
+
+   remainderQueue.clear();
+   remainderQueue.addScene(scene, camera);
+   remainderQueue.sort();
+   remainderQueue.submit(RenderData(), threadPool);
+}
+
+void SceneRenderer::prepareGBuffer(GLsizei width, GLsizei height) {
+   if (!gBuffer) {
+      gBuffer = std::make_unique<Framebuffer>(width, height, true, kGBufferFormats);
+   } else if (gBuffer->getWidth() != width || gBuffer->getHeight() != height) {
+      gBuffer->setResolution(width, height);
+   }
+}
+
+void SceneRenderer::prepareLighting() {
+   if (lightingProgram) {
+      return;
+   }
+
+   lightingProgram = std::make_shared<ShaderProgram>();
+   lightingProgram->attach(compileShader(GL_VERTEX_SHADER, kLightingVertexSource));
+   lightingProgram->attach(compileShader(GL_FRAGMENT_SHADER, getLightingFragmentSource().c_str()));
+   if (!lightingProgram->link()) {
+      LOG_ERROR("Unable to link deferred lighting shader program");
+   }
+
+   transformUniform = lightingProgram->getUniform<glm::mat4>("uTransform");
+   inverseViewProjUniform = lightingProgram->getUniform<glm::mat4>("uInverseViewProjMatrix");
+   lightVolumeUniform = lightingProgram->getUniform<bool>("uLightVolume");
+   lightColorUniform = lightingProgram->getUniform<glm::vec4>("uLight.color");
+   lightPositionFalloffUniform = lightingProgram->getUniform<glm::vec4>("uLight.positionFalloff");
+   lightDirectionBeamUniform = lightingProgram->getUniform<glm::vec4>("uLight.directionBeam");
+   lightCutoffUniform = lightingProgram->getUniform<glm::vec4>("uLight.cutoff");
+   albedoUniform = lightingProgram->getUniform<GLint>("uGBufferAlbedo");
+   normalUniform = lightingProgram->getUniform<GLint>("uGBufferNormal");
+   materialUniform = lightingProgram->getUniform<GLint>("uGBufferMaterial");
+   depthUniform = lightingProgram->getUniform<GLint>("uGBufferDepth");
+
+   fullscreenMesh = createFullscreenMesh();
+   sphereMesh = createSphereMesh();
+   coneMesh = createConeMesh();
+}
+
+void SceneRenderer::renderLighting(const Scene& scene, const CameraComponent& camera, bool depthTested) {
+   prepareLighting();
+
+   const FrameUniformData& frameData = scene.getFrameUniformData();
+   inverseViewProjUniform.set(glm::inverse(frameData.viewProjMatrix));
+
+   // The G-buffer textures stay bound for every lighting draw
+   RenderData renderData;
+   bindGBufferTexture(renderData, albedoUniform, gBuffer->getColorAttachment(kAlbedo));
+   bindGBufferTexture(renderData, normalUniform, gBuffer->getColorAttachment(kNormal));
+   bindGBufferTexture(renderData, materialUniform, gBuffer->getColorAttachment(kMaterial));
+   bindGBufferTexture(renderData, depthUniform, gBuffer->getDepthStencilAttachment());
+
+   // Everything changed here is restored afterwards, so that later draws (e.g. translucent models) see the caller's state
+   Context* context = Context::current();
+   bool blendEnabled = context->isEnabled(GL_BLEND);
+   GLenum blendSourceFactor = context->getBlendSourceFactor();
+   GLenum blendDestinationFactor = context->getBlendDestinationFactor();
+   bool cullFaceEnabled = context->isEnabled(GL_CULL_FACE);
+   GLenum cullFace = context->getCullFace();
+   bool depthTestEnabled = context->isEnabled(GL_DEPTH_TEST);
+   GLenum depthFunc = context->getDepthFunc();
+   bool depthMask = context->getDepthMask();
+
+   // Unbounded lights and emission cover every pixel with geometry once
+   context->disable(GL_DEPTH_TEST);
+   context->setDepthMask(false);
+   context->disable(GL_BLEND);
+   context->disable(GL_CULL_FACE);
+
+   lightVolumeUniform.set(false);
+   transformUniform.set(glm::mat4(1.0f));
+   lightingProgram->commit();
+   fullscreenMesh->draw();
+
+   // Volumes are added on top. Only their back faces are drawn, so that volumes containing the camera still cover the
+   // screen, and (with depth testing) only the pixels in front of the back faces are shaded.
+   context->enable(GL_BLEND);
+   context->setBlendFunc(GL_ONE, GL_ONE);
+   context->enable(GL_CULL_FACE);
+   context->setCullFace(GL_FRONT);
+   if (depthTested) {
+      context->enable(GL_DEPTH_TEST);
+      context->setDepthFunc(GL_GEQUAL);
+   }
+
+   lightVolumeUniform.set(true);
+
+   const DynamicBvh& lightSpatialIndex = scene.getLightSpatialIndex();
+   lightSpatialIndex.query(camera.getFrustum(), [this, &lightSpatialIndex, &frameData](DynamicBvh::ProxyId proxyId) {
+      renderLightVolume(*static_cast<LightComponent*>(lightSpatialIndex.getUserData(proxyId)), frameData.viewProjMatrix);
+      return true;
+   });
+
+   context->setCullFace(cullFace);
+   context->setEnabled(GL_CULL_FACE, cullFaceEnabled);
+   context->setBlendFunc(blendSourceFactor, blendDestinationFactor);
+   context->setEnabled(GL_BLEND, blendEnabled);
+   context->setDepthFunc(depthFunc);
+   context->setDepthMask(depthMask);
+   context->setEnabled(GL_DEPTH_TEST, depthTestEnabled);
+}
+
+void SceneRenderer::renderLightVolume(const LightComponent& light, const glm::mat4& viewProjMatrix) {
+   FrameUniformData::Light lightData;
+   light.writeFrameData(lightData);
+
+   BoundingSphere sphere = light.getWorldBoundingSphere();
+   float cutoffAngle = lightData.cutoff.x;
+
+   Mesh* mesh = sphereMesh.get();
+   Transform volumeTransform({}, sphere.center, glm::vec3(sphere.radius));
+   if (static_cast<int>(lightData.color.a) == FrameUniforms::kSpot && cutoffAngle <= kMaxConeVolumeAngle) {
+      // Everything within the light's range and cutoff angle is inside the cone
+      float baseRadius = sphere.radius * std::tan(cutoffAngle);
+
+      mesh = coneMesh.get();
+      volumeTransform.orientation = light.getAbsoluteTransform().orientation;
+      volumeTransform.scale = glm::vec3(baseRadius, baseRadius, sphere.radius);
+   }
+
+   transformUniform.set(viewProjMatrix * volumeTransform.toMatrix());
+   lightColorUniform.set(lightData.color);
+   lightPositionFalloffUniform.set(lightData.positionFalloff);
+   lightDirectionBeamUniform.set(lightData.directionBeam);
+   lightCutoffUniform.set(lightData.cutoff);
+
+   lightingProgram->commit();
+   mesh->draw();
+}
+
+void SceneRenderer::bindGBufferTexture(RenderData& renderData, const UniformHandle<GLint>& uniform, const SPtr<Texture>& texture) {
+   GLint textureUnit = renderData.aquireTextureUnit();
+   Context::current()->activeTexture(textureUnit);
+   texture->bind();
+
+   uniform.set(textureUnit);
+}
+
+} // namespace Shiny
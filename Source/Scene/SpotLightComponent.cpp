@@ -6,7 +6,7 @@ namespace Shiny {
 void SpotLightComponent::apply(ShaderProgram& program, RenderData& renderData) {
    LightComponent::apply(program, renderData);
 
-   Transform absoluteTransform = getAbsoluteTransform();
+   const Transform& absoluteTransform = getAbsoluteTransform();
 
    if (program.hasUniform("uLight.position")) {
       program.setUniformValue("uLight.position", absoluteTransform.position);
@@ -29,6 +29,20 @@ void SpotLightComponent::apply(ShaderProgram& program, RenderData& renderData) {
    }
 }
 
+void SpotLightComponent::writeFrameData(FrameUniformData::Light& light) const {
+   LightComponent::writeFrameData(light);
+
+   light.color.a = static_cast<float>(FrameUniforms::kSpot);
+   light.positionFalloff.w = squareFalloff;
+   light.directionBeam = glm::vec4(getAbsoluteTransform().orientation * glm::vec3(0.0f, 0.0f, -1.0f), beamAngle);
+   light.cutoff.x = cutoffAngle;
+}
+
+BoundingSphere SpotLightComponent::getWorldBoundingSphere() const {
+   // Conservative - the cone is fully contained by the sphere
+   return BoundingSphere(getAbsoluteTransform().position, getFalloffRadius(squareFalloff));
+}
+
 SHINY_REGISTER_COMPONENT(SpotLightComponent)
 
 } // namespace Shiny
@@ -1,7 +1,55 @@
+#include "Shiny/Scene/Scene.h"
 #include "Shiny/Scene/TransformComponent.h"
 
+#include <algorithm>
+
 namespace Shiny {
 
+TransformComponent::TransformComponent(Entity& entity)
+   : Component(entity), hierarchy(entity.getScene().getTransformHierarchy()), hierarchyIndex(TransformHierarchy::kInvalidIndex), parent(nullptr) {
+   hierarchy.add(this);
+}
+
+TransformComponent::~TransformComponent() {
+   // Iterate over a copy, since orphaning a child removes it from the list
+   std::vector<TransformComponent*> childrenCopy = children;
+   for (TransformComponent* child : childrenCopy) {
+      child->setParent(nullptr);
+   }
+
+   if (parent) {
+      auto itr = std::find(parent->children.begin(), parent->children.end(), this);
+      ASSERT(itr != parent->children.end());
+      parent->children.erase(itr);
+      parent = nullptr;
+   }
+
+   hierarchy.remove(hierarchyIndex);
+}
+
+void TransformComponent::setParent(TransformComponent* newParent) {
+   if (newParent && &getOwner() != &newParent->getOwner()) {
+      return;
+   }
+
+   if (newParent == parent) {
+      return;
+   }
+
+   if (parent) {
+      auto itr = std::find(parent->children.begin(), parent->children.end(), this);
+      ASSERT(itr != parent->children.end());
+      parent->children.erase(itr);
+   }
+
+   parent = newParent;
+   if (parent) {
+      parent->children.push_back(this);
+   }
+
+   hierarchy.reparent(this);
+}
+
 SHINY_REGISTER_COMPONENT(TransformComponent)
 
 } // namespace Shiny
@@ -0,0 +1,225 @@
+#include "Shiny/Math/TransformBatch.h"
+#include "Shiny/Platform/ThreadPool.h"
+#include "Shiny/Scene/TransformComponent.h"
+#include "Shiny/Scene/TransformHierarchy.h"
+
+namespace Shiny {
+
+namespace {
+
+// Levels smaller than this are updated on the calling thread, since handing them to the pool costs more than it saves
+const std::size_t kMinParallelLevelSize = 1024;
+const std::size_t kMinNodesPerTask = 256;
+
+// Number of parent world transforms gathered at a time when batching an update
+const std::size_t kUpdateBatchSize = 64;
+
+} // namespace
+
+// static
+const TransformHierarchy::NodeIndex TransformHierarchy::kInvalidIndex;
+
+void TransformHierarchy::update(ThreadPool* threadPool) {
+   ++stampCounter;
+
+   for (std::uint32_t depth = 0; depth < levelEnds.size(); ++depth) {
+      NodeIndex begin = getLevelBegin(depth);
+      NodeIndex end = levelEnds[depth];
+
+      // Nodes within a level never depend on each other, only on the (already updated) previous level
+      if (threadPool && end - begin >= kMinParallelLevelSize) {
+         threadPool->parallelFor(end - begin, kMinNodesPerTask, [this, begin](std::size_t rangeBegin, std::size_t rangeEnd) {
+            updateRange(begin + static_cast<NodeIndex>(rangeBegin), begin + static_cast<NodeIndex>(rangeEnd));
+         });
+      } else {
+         updateRange(begin, end);
+      }
+   }
+}
+
+TransformHierarchy::NodeIndex TransformHierarchy::add(TransformComponent* owner) {
+   ASSERT(owner && !owner->getParent());
+   ASSERT(owners.size() < kInvalidIndex, "Too many transforms in hierarchy");
+
+   return insertAtDepth(0, owner, kInvalidIndex, Transform());
+}
+
+void TransformHierarchy::remove(NodeIndex index) {
+   ASSERT(index < owners.size(), "Trying to remove invalid transform node");
+
+   owners[index]->hierarchyIndex = kInvalidIndex;
+
+   // Fill the hole with the last node of the same level, which moves the hole to the end of the level. Then keep pushing
+   // the hole to the end of each following level (by moving in that level's last node) until it reaches the end.
+   std::uint32_t depth = depths[index];
+   NodeIndex hole = index;
+
+   NodeIndex last = levelEnds[depth] - 1;
+   if (hole != last) {
+      moveNode(last, hole);
+      hole = last;
+   }
+   --levelEnds[depth];
+
+   for (std::uint32_t laterDepth = depth + 1; laterDepth < levelEnds.size(); ++laterDepth) {
+      if (levelEnds[laterDepth] > hole + 1) {
+         NodeIndex lastInLevel = levelEnds[laterDepth] - 1;
+         moveNode(lastInLevel, hole);
+         hole = lastInLevel;
+      }
+      --levelEnds[laterDepth];
+   }
+
+   ASSERT(hole == owners.size() - 1);
+   localTransforms.pop_back();
+   parentIndices.pop_back();
+   worldTransforms.pop_back();
+   worldMatrices.pop_back();
+   normalMatrices.pop_back();
+   dirtyFlags.pop_back();
+   worldStamps.pop_back();
+   depths.pop_back();
+   owners.pop_back();
+
+   while (!levelEnds.empty() && levelEnds.back() == getLevelBegin(static_cast<std::uint32_t>(levelEnds.size() - 1))) {
+      levelEnds.pop_back();
+   }
+}
+
+void TransformHierarchy::reparent(TransformComponent* owner) {
+   std::vector<TransformComponent*> subtree;
+   collectSubtree(owner, subtree);
+
+   std::vector<Transform> subtreeLocalTransforms;
+   subtreeLocalTransforms.reserve(subtree.size());
+   for (TransformComponent* node : subtree) {
+      subtreeLocalTransforms.push_back(localTransforms[node->hierarchyIndex]);
+   }
+
+   // Children before parents
+   for (auto itr = subtree.rbegin(); itr != subtree.rend(); ++itr) {
+      remove((*itr)->hierarchyIndex);
+   }
+
+   // Parents before children, so that each parent's index is final by the time its children are inserted
+   for (std::size_t i = 0; i < subtree.size(); ++i) {
+      TransformComponent* parent = subtree[i]->getParent();
+      NodeIndex parentIndex = parent ? parent->hierarchyIndex : kInvalidIndex;
+      std::uint32_t depth = parent ? depths[parentIndex] + 1 : 0;
+
+      insertAtDepth(depth, subtree[i], parentIndex, subtreeLocalTransforms[i]);
+   }
+}
+
+void TransformHierarchy::markDirty(NodeIndex index) {
+   // Descendants of a dirty node are already dirty, so propagation can stop there
+   if (dirtyFlags[index]) {
+      return;
+   }
+
+   dirtyFlags[index] = 1;
+   owners[index]->onWorldTransformInvalidated();
+
+   for (TransformComponent* child : owners[index]->children) {
+      markDirty(child->hierarchyIndex);
+   }
+}
+
+TransformHierarchy::NodeIndex TransformHierarchy::insertAtDepth(std::uint32_t depth, TransformComponent* owner, NodeIndex parentIndex, const Transform& localTransform) {
+   while (levelEnds.size() <= depth) {
+      levelEnds.push_back(static_cast<NodeIndex>(owners.size()));
+   }
+
+   localTransforms.emplace_back();
+   parentIndices.push_back(kInvalidIndex);
+   worldTransforms.emplace_back();
+   worldMatrices.emplace_back(1.0f);
+   normalMatrices.emplace_back(1.0f);
+   dirtyFlags.push_back(1);
+   worldStamps.push_back(0);
+   depths.push_back(0);
+   owners.push_back(nullptr);
+
+   // Open up a hole at the end of the target level by moving the first node of each deeper level to the end of that level
+   NodeIndex hole = static_cast<NodeIndex>(owners.size() - 1);
+   for (std::uint32_t laterDepth = static_cast<std::uint32_t>(levelEnds.size() - 1); laterDepth > depth; --laterDepth) {
+      NodeIndex begin = getLevelBegin(laterDepth);
+      if (begin != hole) {
+         moveNode(begin, hole);
+      }
+
+      hole = begin;
+      ++levelEnds[laterDepth];
+   }
+   ++levelEnds[depth];
+
+   localTransforms[hole] = localTransform;
+   parentIndices[hole] = parentIndex;
+   dirtyFlags[hole] = 1;
+   worldStamps[hole] = 0;
+   depths[hole] = depth;
+   owners[hole] = owner;
+   owner->hierarchyIndex = hole;
+
+   owner->onWorldTransformInvalidated();
+
+   return hole;
+}
+
+void TransformHierarchy::moveNode(NodeIndex from, NodeIndex to) {
+   localTransforms[to] = localTransforms[from];
+   parentIndices[to] = parentIndices[from];
+   worldTransforms[to] = worldTransforms[from];
+   worldMatrices[to] = worldMatrices[from];
+   normalMatrices[to] = normalMatrices[from];
+   dirtyFlags[to] = dirtyFlags[from];
+   worldStamps[to] = worldStamps[from];
+   depths[to] = depths[from];
+   owners[to] = owners[from];
+
+   owners[to]->hierarchyIndex = to;
+   for (TransformComponent* child : owners[to]->children) {
+      // Children that are currently detached (while reparenting) are re-linked when they are inserted again
+      if (child->hierarchyIndex != kInvalidIndex) {
+         parentIndices[child->hierarchyIndex] = to;
+      }
+   }
+}
+
+void TransformHierarchy::updateRange(NodeIndex begin, NodeIndex end) {
+   Transform parentWorldTransforms[kUpdateBatchSize];
+
+   NodeIndex index = begin;
+   while (index < end) {
+      if (!dirtyFlags[index]) {
+         ++index;
+         continue;
+      }
+
+      NodeIndex batchBegin = index;
+      NodeIndex batchEnd = batchBegin;
+      while (batchEnd < end && batchEnd - batchBegin < kUpdateBatchSize && dirtyFlags[batchEnd]) {
+         NodeIndex parentIndex = parentIndices[batchEnd];
+         parentWorldTransforms[batchEnd - batchBegin] = parentIndex == kInvalidIndex ? Transform() : worldTransforms[parentIndex];
+         dirtyFlags[batchEnd] = 0;
+         worldStamps[batchEnd] = stampCounter;
+         ++batchEnd;
+      }
+
+      std::size_t count = batchEnd - batchBegin;
+      TransformBatch::multiply(&worldTransforms[batchBegin], &localTransforms[batchBegin], parentWorldTransforms, count);
+      TransformBatch::toMatrix(&worldMatrices[batchBegin], &worldTransforms[batchBegin], count);
+      TransformBatch::toNormalMatrix(&normalMatrices[batchBegin], &worldTransforms[batchBegin], count);
+
+      index = batchEnd;
+   }
+}
+
+void TransformHierarchy::collectSubtree(TransformComponent* owner, std::vector<TransformComponent*>& subtree) const {
+   subtree.push_back(owner);
+   for (TransformComponent* child : owner->children) {
+      collectSubtree(child, subtree);
+   }
+}
+
+} // namespace Shiny
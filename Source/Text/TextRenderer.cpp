@@ -1,5 +1,6 @@
 #include "Shiny/ShinyAssert.h"
 
+#include "Shiny/Graphics/Context.h"
 #include "Shiny/Graphics/Framebuffer.h"
 #include "Shiny/Graphics/Mesh.h"
 #include "Shiny/Graphics/RenderData.h"
@@ -79,7 +80,10 @@ SPtr<Texture> TextRenderer::renderToTexture(const char *text, int *textureWidth,
    framebuffer->bind();
    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
    glClear(GL_COLOR_BUFFER_BIT);
-   glDisable(GL_DEPTH_TEST);
+
+   Context* context = Context::current();
+   bool depthTestEnabled = context->isEnabled(GL_DEPTH_TEST);
+   context->disable(GL_DEPTH_TEST);
 
    textureMaterial->setTexture(atlas->getTexture());
    FontSpacing spacing = atlas->getFontSpacing();
@@ -87,7 +91,7 @@ SPtr<Texture> TextRenderer::renderToTexture(const char *text, int *textureWidth,
       render(quad, model, spacing.descent);
    }
 
-   glEnable(GL_DEPTH_TEST);
+   context->setEnabled(GL_DEPTH_TEST, depthTestEnabled);
    Framebuffer::bindDefaultFramebuffer();
 
    return framebuffer->getColorAttachment(0);
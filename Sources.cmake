@@ -12,8 +12,12 @@ set(SOURCE_NAMES
    Audio/Stream.cpp
    Entity/Component.cpp
    Entity/Entity.cpp
+   Entity/SystemScheduler.cpp
    Graphics/Context.cpp
    Graphics/Framebuffer.cpp
+   Graphics/FrameStats.cpp
+   Graphics/FrameUniforms.cpp
+   Graphics/GpuProfiler.cpp
    Graphics/Mesh.cpp
    Graphics/Model.cpp
    Graphics/RenderData.cpp
@@ -25,17 +29,26 @@ set(SOURCE_NAMES
    Input/ControllerMap.cpp
    Input/Keyboard.cpp
    Input/Mouse.cpp
+   Math/DynamicBvh.cpp
+   Math/Frustum.cpp
+   Math/TransformBatch.cpp
    Platform/IOUtils.cpp
    Platform/OSUtils.cpp
    Platform/Path.cpp
+   Platform/ThreadPool.cpp
    Scene/CameraComponent.cpp
    Scene/DirectionalLightComponent.cpp
+   Scene/LightClusters.cpp
    Scene/LightComponent.cpp
    Scene/ModelComponent.cpp
    Scene/PointLightComponent.cpp
+   Scene/RenderCommandList.cpp
+   Scene/RenderQueue.cpp
    Scene/Scene.cpp
+   Scene/SceneRenderer.cpp
    Scene/SpotLightComponent.cpp
    Scene/TransformComponent.cpp
+   Scene/TransformHierarchy.cpp
    Text/Font.cpp
    Text/FontAtlas.cpp
    Text/TextRenderer.cpp